@@ -2,10 +2,44 @@
 #include <SDL2/SDL_ttf.h>
 
 #include <vector>
+#include <list>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
 #include <functional>
 #include <algorithm>
+#include <string.h>
 #include <math.h>
 
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
+
 typedef enum
 {
     MUI_SCALING_SCALE = 0,
@@ -24,6 +58,14 @@ typedef enum
     MUI_DRAGGED = 3
 } MUI_EVENTS;
 
+typedef enum
+{
+    MUI_LAYOUT_NONE = 0,
+    MUI_LAYOUT_VERTICAL = 1,
+    MUI_LAYOUT_HORIZONTAL = 2,
+    MUI_LAYOUT_GRID = 3
+} MUI_LAYOUT;
+
 
 class MUI_Vector2
 {
@@ -140,7 +182,11 @@ class MUI_Element
 public:
     SDL_Color    backgroundColor;
     SDL_Texture *texture;
-    SDL_Rect     destRect;
+    SDL_Surface *surface = nullptr;
+    SDL_Rect     destRect = {0, 0, 0, 0};
+
+    // Keep the text surface around for the software backend, see MUI_RetainSurface.
+    bool keepSurface = false;
     SDL_Rect    *srcRect;
 
     int scaling;
@@ -159,16 +205,50 @@ public:
     std::function<void()> Clicked;
     std::function<void()> Hovered;
 
+    // Custom drawing, called after the background and texture with destRect already laid out.
+    std::function<void(SDL_Renderer*, MUI_Element*)> Draw;
+
     MUI_Vector2 position;
     MUI_Vector2 size;
 
+    // Container layout, children of a container ignore their position / size and are placed by MUI_ElementArrange.
+    int   layout        = MUI_LAYOUT_NONE;
+    int   layoutColumns = 1;
+    int   layoutSpacing = 0;
+    int   layoutPadding = 0;
+    float flexGrow      = 0.0f;
+    bool  autoSize      = false;
+
+    bool measureDirty = true;
+    bool arrangeDirty = true;
+    int  measuredW    = 0;
+    int  measuredH    = 0;
+    int  arrangedW    = -1;
+    int  arrangedH    = -1;
+    SDL_Rect layoutRect = {0, 0, 0, 0};
+
 } typedef MUI_Element;
 
+class MUI_Binding;
+class MUI_SoftwareBackend;
+
+class MUI_Profiler
+{
+public:
+    float frameTime          = 0.0f;
+
+    // Milliseconds between sampling the mouse and submitting the dragged element drawn at that position.
+    float dragLatency        = 0.0f;
+    float dragLatencyAverage = 0.0f;
+    Uint32 dragLatencySamples = 0;
+};
+
 class MUI_Updater
 {
 public:
     int mouseX;
     int mouseY;
+    Uint64 mouseCounter = 0;
 
     int windowSizeX;
     int windowSizeY;
@@ -180,6 +260,43 @@ public:
 
     int event;
 
+    bool mouseUp   = false;
+    bool mouseDown = false;
+    bool dragged   = false;
+
+    std::vector<MUI_Element*> eventElements;
+
+    std::vector<float> layoutSource;
+
+    // Low latency drag: the dragged subtree is skipped by MUI_Update and drawn by MUI_RenderDragLate
+    // from a mouse position sampled right before present. dragPrediction extrapolates that many milliseconds ahead.
+    bool  lowLatencyDrag = false;
+    float dragPrediction = 0.0f;
+
+    MUI_Element *deferredElement = nullptr;
+
+    // dragPositionCounter is the mouse sample the dragged position came from, dragRectCounter the one waiting to be
+    // drawn. A sample is only counted once, holding a drag still adds no latency samples.
+    Uint64 dragPositionCounter = 0;
+    Uint64 dragAppliedCounter  = 0;
+    Uint64 dragRectCounter     = 0;
+    Uint64 dragLastCounter     = 0;
+    int    dragLastX           = 0;
+    int    dragLastY           = 0;
+    float  dragVelocityX       = 0.0f;
+    float  dragVelocityY       = 0.0f;
+
+    MUI_Profiler profiler;
+
+    std::vector<MUI_Binding*> bindings;
+
+    // When set, elements are drawn by MUI_SoftwareBackendPresent instead of the SDL renderer.
+    MUI_SoftwareBackend *backend = nullptr;
+
+    // Set by MUI_CreateOffscreenUpdater, a software renderer drawing into offscreenSurface.
+    SDL_Surface  *offscreenSurface  = nullptr;
+    SDL_Renderer *offscreenRenderer = nullptr;
+
     MUI_Updater(SDL_Window *window)
     {
         SDL_GetWindowSize(window, &this->windowSizeX, &this->windowSizeY);
@@ -206,17 +323,35 @@ public:
     MUI_Element element;
 } typedef MUI_Text;
 
+// Marks element and its ancestors for remeasure. Call after changing anything a container measures:
+// a child's texture, visibility, OFFSET size, flexGrow or the container's layout settings.
+void MUI_ElementInvalidateLayout(MUI_Element *element)
+{
+    while (element != nullptr)
+    {
+        element->measureDirty = true;
+        element->arrangeDirty = true;
+        element = element->parent;
+    }
+}
+
 void MUI_ElementSetParent(MUI_Element *element, MUI_Element *parent)
 {
     if (element->parent != parent)
     {
         if (element->parent != nullptr)
+        {
             element->parent->childs.erase(std::find(element->parent->childs.begin(), element->parent->childs.end(), element));
+            MUI_ElementInvalidateLayout(element->parent);
+        }
 
         element->parent = parent;
 
         if (parent != nullptr)
+        {
             parent->childs.push_back(element);
+            MUI_ElementInvalidateLayout(parent);
+        }
     }
 }
 
@@ -244,12 +379,38 @@ MUI_Element *MUI_CreateFrame(SDL_Renderer *renderer, SDL_Color backgroundColor,
     element->mouseDown       = false;
 
     element->Hovered         = nullptr;
+    element->Draw            = nullptr;
     element->Clicked         = nullptr;
 
     return element;
 }
 
-MUI_Element *MUI_CreateText(SDL_Renderer *renderer, const char *text, TTF_Font *font, SDL_Color textColor, SDL_Color backgroundColor, MUI_Vector2 position, MUI_Vector2 size, int scaling, int scaleTo, bool clickable, bool draggable)
+// Converts a surface to ARGB8888 for the software backend, takes ownership of surface.
+SDL_Surface *MUI_ConvertSurface(SDL_Surface *surface)
+{
+    if (surface == nullptr || surface->format->format == SDL_PIXELFORMAT_ARGB8888)
+        return surface;
+
+    SDL_Surface *converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(surface);
+
+    return converted;
+}
+
+// Text surfaces are only kept for elements drawn by a software backend, takes ownership of surface.
+SDL_Surface *MUI_RetainSurface(SDL_Surface *surface, bool keepSurface)
+{
+    if (surface != nullptr && !keepSurface)
+    {
+        SDL_FreeSurface(surface);
+        return nullptr;
+    }
+
+    return surface;
+}
+
+// keepSurface has to be set for text drawn through a software backend.
+MUI_Element *MUI_CreateText(SDL_Renderer *renderer, const char *text, TTF_Font *font, SDL_Color textColor, SDL_Color backgroundColor, MUI_Vector2 position, MUI_Vector2 size, int scaling, int scaleTo, bool clickable, bool draggable, bool keepSurface = false)
 {
     MUI_Element *element = new MUI_Element;
 
@@ -278,9 +439,11 @@ MUI_Element *MUI_CreateText(SDL_Renderer *renderer, const char *text, TTF_Font *
     element->mouseDown       = false;
 
     element->Hovered         = nullptr;
+    element->Draw            = nullptr;
     element->Clicked         = nullptr;
 
-    SDL_FreeSurface(surface);
+    element->keepSurface     = keepSurface;
+    element->surface         = MUI_RetainSurface(surface, keepSurface);
 
     return element;
 }
@@ -291,9 +454,12 @@ void MUI_UpdateText(SDL_Renderer *renderer, MUI_Element *element, const char *te
     SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
 
     SDL_DestroyTexture(element->texture);
-    SDL_FreeSurface(surface);
+    SDL_FreeSurface(element->surface);
 
     element->texture = texture;
+    element->surface = MUI_RetainSurface(surface, element->keepSurface);
+
+    MUI_ElementInvalidateLayout(element);
 }
 
 void MUI_ElementCopy(MUI_Element *copyFrom, MUI_Element *copyTo)
@@ -302,13 +468,46 @@ void MUI_ElementCopy(MUI_Element *copyFrom, MUI_Element *copyTo)
     copyTo->clickable       = copyFrom->clickable;
     copyTo->backgroundColor = copyFrom->backgroundColor;
     copyTo->texture         = copyFrom->texture;
+
+    if (copyFrom->surface != nullptr)
+        copyFrom->surface->refcount++;
+    if (copyTo->surface != nullptr)
+        SDL_FreeSurface(copyTo->surface);
+
+    copyTo->surface         = copyFrom->surface;
+    copyTo->keepSurface     = copyFrom->keepSurface;
     copyTo->position        = copyFrom->position;
     copyTo->size            = copyFrom->size;
     copyTo->scaling         = copyFrom->scaling;
     copyTo->scaleTo         = copyFrom->scaleTo;
     copyTo->Hovered         = copyFrom->Hovered;
     copyTo->Clicked         = copyFrom->Clicked;
+    copyTo->Draw            = copyFrom->Draw;
     copyTo->mouseDown       = copyFrom->mouseDown;
+    copyTo->layout          = copyFrom->layout;
+    copyTo->layoutColumns   = copyFrom->layoutColumns;
+    copyTo->layoutSpacing   = copyFrom->layoutSpacing;
+    copyTo->layoutPadding   = copyFrom->layoutPadding;
+    copyTo->flexGrow        = copyFrom->flexGrow;
+    copyTo->autoSize        = copyFrom->autoSize;
+
+    MUI_ElementInvalidateLayout(copyTo);
+}
+
+void MUI_DestroyElement(MUI_Element *element)
+{
+    MUI_ElementSetParent(element, nullptr);
+
+    for (MUI_Element *child : element->childs)
+        child->parent = nullptr;
+
+    if (element->texture != nullptr)
+        SDL_DestroyTexture(element->texture);
+
+    if (element->surface != nullptr)
+        SDL_FreeSurface(element->surface);
+
+    delete element;
 }
 
 void MUI_UpdateCopy(MUI_Updater *muiUpdater, MUI_Element *element)
@@ -321,10 +520,6 @@ void MUI_UpdateClear(MUI_Updater *muiUpdater)
     muiUpdater->elements = {};
 }
 
-bool mouseUp = false;
-bool mouseDown = false;
-bool dragged = false;
-
 constexpr void MUI_ElementUpdatedestRect(MUI_Element *element, MUI_Updater *updater)
 {
     switch (element->scaling)
@@ -370,6 +565,324 @@ constexpr void MUI_ElementUpdatedestRect(MUI_Element *element, MUI_Updater *upda
     }
 }
 
+// Measure pass, the size an element wants from its content. Cached until MUI_ElementInvalidateLayout.
+void MUI_ElementMeasure(MUI_Element *element)
+{
+    if (!element->measureDirty)
+        return;
+
+    int w = 0;
+    int h = 0;
+
+    if (element->layout == MUI_LAYOUT_NONE)
+    {
+        if (element->texture != nullptr)
+            SDL_QueryTexture(element->texture, nullptr, nullptr, &w, &h);
+        else if (element->scaling == MUI_SCALING_OFFSET)
+        {
+            w = (int)element->size.X;
+            h = (int)element->size.Y;
+        }
+    }
+    else
+    {
+        int count = 0;
+        int maxW  = 0;
+        int maxH  = 0;
+        int sumW  = 0;
+        int sumH  = 0;
+
+        for (MUI_Element *child : element->childs)
+        {
+            if (!child->visible)
+                continue;
+
+            MUI_ElementMeasure(child);
+
+            maxW  = SDL_max(maxW, child->measuredW);
+            maxH  = SDL_max(maxH, child->measuredH);
+            sumW += child->measuredW;
+            sumH += child->measuredH;
+            count++;
+        }
+
+        int gaps = SDL_max(count - 1, 0) * element->layoutSpacing;
+
+        switch (element->layout)
+        {
+        case MUI_LAYOUT_VERTICAL:
+            w = maxW;
+            h = sumH + gaps;
+            break;
+        case MUI_LAYOUT_HORIZONTAL:
+            w = sumW + gaps;
+            h = maxH;
+            break;
+        case MUI_LAYOUT_GRID:
+        {
+            int columns = SDL_max(element->layoutColumns, 1);
+            int rows    = (count + columns - 1) / columns;
+
+            w = columns * maxW + SDL_max(columns - 1, 0) * element->layoutSpacing;
+            h = rows    * maxH + SDL_max(rows - 1, 0)    * element->layoutSpacing;
+            break;
+        }
+        }
+
+        w += element->layoutPadding * 2;
+        h += element->layoutPadding * 2;
+    }
+
+    element->measuredW    = w;
+    element->measuredH    = h;
+    element->measureDirty = false;
+}
+
+// Arrange pass, writes each visible child's layoutRect relative to the container. Skipped when nothing was
+// invalidated and the container kept its size, so a change only re-arranges the containers above it.
+void MUI_ElementArrange(MUI_Element *element)
+{
+    int w = element->destRect.w;
+    int h = element->destRect.h;
+
+    if (!element->arrangeDirty && element->arrangedW == w && element->arrangedH == h)
+        return;
+
+    MUI_ElementMeasure(element);
+
+    int padding = element->layoutPadding;
+    int spacing = element->layoutSpacing;
+    int innerW  = SDL_max(w - padding * 2, 0);
+    int innerH  = SDL_max(h - padding * 2, 0);
+
+    int   count = 0;
+    int   used  = 0;
+    float grow  = 0.0f;
+
+    for (MUI_Element *child : element->childs)
+    {
+        if (!child->visible)
+            continue;
+
+        used += (element->layout == MUI_LAYOUT_HORIZONTAL) ? child->measuredW : child->measuredH;
+        grow += child->flexGrow;
+        count++;
+    }
+
+    int extra = ((element->layout == MUI_LAYOUT_HORIZONTAL) ? innerW : innerH) - used - SDL_max(count - 1, 0) * spacing;
+
+    int columns = SDL_max(element->layoutColumns, 1);
+    int rows    = SDL_max((count + columns - 1) / columns, 1);
+    int cellW   = (innerW - (columns - 1) * spacing) / columns;
+    int cellH   = (innerH - (rows - 1)    * spacing) / rows;
+
+    int cursor = padding;
+    int index  = 0;
+
+    for (MUI_Element *child : element->childs)
+    {
+        if (!child->visible)
+            continue;
+
+        SDL_Rect rect = {padding, padding, 0, 0};
+        int share = (extra > 0 && grow > 0.0f) ? (int)((float)extra * child->flexGrow / grow) : 0;
+
+        switch (element->layout)
+        {
+        case MUI_LAYOUT_VERTICAL:
+            rect.y = cursor;
+            rect.w = child->autoSize ? child->measuredW : innerW;
+            rect.h = child->measuredH + share;
+            cursor += rect.h + spacing;
+            break;
+        case MUI_LAYOUT_HORIZONTAL:
+            rect.x = cursor;
+            rect.w = child->measuredW + share;
+            rect.h = child->autoSize ? child->measuredH : innerH;
+            cursor += rect.w + spacing;
+            break;
+        case MUI_LAYOUT_GRID:
+            rect.x = padding + (index % columns) * (cellW + spacing);
+            rect.y = padding + (index / columns) * (cellH + spacing);
+            rect.w = child->autoSize ? child->measuredW : cellW;
+            rect.h = child->autoSize ? child->measuredH : cellH;
+            break;
+        }
+
+        child->layoutRect = rect;
+        index++;
+    }
+
+    element->arrangedW    = w;
+    element->arrangedH    = h;
+    element->arrangeDirty = false;
+}
+
+// Computes dst[i] = (int)(src[i] * scale[i % 4]) + offset[i % 4] for count elements of four lanes (x, y, w, h).
+// Every path multiplies in single precision and truncates toward zero, so results match MUI_ElementUpdatedestRect exactly.
+void MUI_LayoutKernel(const float *src, size_t count, const float *scale, const int *offset, int *dst)
+{
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    __m256  scale8  = _mm256_setr_ps(scale[0], scale[1], scale[2], scale[3], scale[0], scale[1], scale[2], scale[3]);
+    __m256i offset8 = _mm256_setr_epi32(offset[0], offset[1], offset[2], offset[3], offset[0], offset[1], offset[2], offset[3]);
+
+    for (; i + 2 <= count; i += 2)
+    {
+        __m256i rect = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src + i * 4), scale8));
+        _mm256_storeu_si256((__m256i*)(dst + i * 4), _mm256_add_epi32(rect, offset8));
+    }
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    __m128  scale4  = _mm_loadu_ps(scale);
+    __m128i offset4 = _mm_loadu_si128((const __m128i*)offset);
+
+    for (; i < count; i++)
+    {
+        __m128i rect = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i * 4), scale4));
+        _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_add_epi32(rect, offset4));
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        dst[i * 4 + 0] = (int)(src[i * 4 + 0] * scale[0]) + offset[0];
+        dst[i * 4 + 1] = (int)(src[i * 4 + 1] * scale[1]) + offset[1];
+        dst[i * 4 + 2] = (int)(src[i * 4 + 2] * scale[2]) + offset[2];
+        dst[i * 4 + 3] = (int)(src[i * 4 + 3] * scale[3]) + offset[3];
+    }
+}
+
+// Batched equivalent of MUI_ElementLayout, writes the rects to rects instead of the elements.
+// Consecutive elements sharing a parent and scaling mode go through MUI_LayoutKernel in one pass,
+// children of a container take the layoutRect its arrange pass produced. Gathering from heap allocated
+// elements costs more than the kernel saves on large sibling lists (see bench/layout_bench.cc), so the
+// frame loop uses MUI_ElementLayout, this is for callers that already hold a packed element array.
+void MUI_LayoutBatch(MUI_Element *const *elements, size_t count, MUI_Updater *updater, SDL_Rect *rects)
+{
+    size_t i = 0;
+
+    while (i < count)
+    {
+        MUI_Element *parent = elements[i]->parent;
+        int scaling = elements[i]->scaling;
+
+        size_t end = i + 1;
+        while (end < count && elements[end]->parent == parent && elements[end]->scaling == scaling)
+            end++;
+
+        int offset[4] = {0, 0, 0, 0};
+
+        if (parent != nullptr)
+        {
+            offset[0] = parent->destRect.x;
+            offset[1] = parent->destRect.y;
+        }
+
+        if (parent != nullptr && parent->layout != MUI_LAYOUT_NONE)
+        {
+            for (size_t j = i; j < end; j++)
+            {
+                rects[j] = elements[j]->layoutRect;
+                rects[j].x += offset[0];
+                rects[j].y += offset[1];
+            }
+        }
+        else if (scaling == MUI_SCALING_SCALE || scaling == MUI_SCALING_OFFSET)
+        {
+            float scale[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+
+            if (scaling == MUI_SCALING_SCALE)
+            {
+                float w = (parent != nullptr) ? (float)parent->destRect.w : (float)updater->windowSizeX;
+                float h = (parent != nullptr) ? (float)parent->destRect.h : (float)updater->windowSizeY;
+
+                scale[0] = w;
+                scale[1] = h;
+                scale[2] = w;
+                scale[3] = h;
+            }
+
+            updater->layoutSource.resize((end - i) * 4);
+            float *source = updater->layoutSource.data();
+
+            for (size_t j = i; j < end; j++, source += 4)
+            {
+                source[0] = elements[j]->position.X;
+                source[1] = elements[j]->position.Y;
+                source[2] = elements[j]->size.X;
+                source[3] = elements[j]->size.Y;
+            }
+
+            MUI_LayoutKernel(updater->layoutSource.data(), end - i, scale, offset, (int*)(rects + i));
+        }
+        else
+        {
+            for (size_t j = i; j < end; j++)
+            {
+                rects[j] = elements[j]->destRect;
+                rects[j].x += offset[0];
+                rects[j].y += offset[1];
+            }
+        }
+
+        i = end;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        MUI_Element *parent = elements[i]->parent;
+
+        if (parent != nullptr && parent->layout != MUI_LAYOUT_NONE)
+            continue;
+
+        if (elements[i]->autoSize)
+        {
+            MUI_ElementMeasure(elements[i]);
+
+            rects[i].w = elements[i]->measuredW;
+            rects[i].h = elements[i]->measuredH;
+            continue;
+        }
+
+        switch (elements[i]->scaleTo)
+        {
+        case MUI_SCALE_XX:
+            rects[i].h = rects[i].w;
+            break;
+        case MUI_SCALE_YY:
+            rects[i].w = rects[i].h;
+            break;
+        }
+    }
+}
+
+// Lays out one element in place, children of a container take the layoutRect its arrange pass produced.
+void MUI_ElementLayout(MUI_Element *element, MUI_Updater *updater)
+{
+    MUI_Element *parent = element->parent;
+
+    if (parent != nullptr && parent->layout != MUI_LAYOUT_NONE)
+    {
+        element->destRect = element->layoutRect;
+        element->destRect.x += parent->destRect.x;
+        element->destRect.y += parent->destRect.y;
+        return;
+    }
+
+    MUI_ElementUpdatedestRect(element, updater);
+
+    if (element->autoSize)
+    {
+        MUI_ElementMeasure(element);
+
+        element->destRect.w = element->measuredW;
+        element->destRect.h = element->measuredH;
+    }
+}
+
 constexpr void MUI_UpdaterChangeEvent(MUI_Updater *updater, MUI_Element *element, int muiEvent_)
 {
     switch (muiEvent_)
@@ -416,10 +929,12 @@ void MUI_ElementCheckEvent(MUI_Updater *updater, MUI_Element *element)
             {
                 MUI_UpdaterChangeEvent(updater, element, MUI_HOVERED);
 
-                if (mouseDown)
+                if (updater->mouseDown)
                 {
                     MUI_UpdaterChangeEvent(updater, element, MUI_DRAGGED);
 
+                    updater->dragPositionCounter = updater->mouseCounter;
+
                     MUI_Vector2 windowSize = MUI_Vector2(updater->windowSizeX, updater->windowSizeY);
                     MUI_Vector2 mousePosition = MUI_Vector2(updater->mouseX, updater->mouseY);
 
@@ -445,14 +960,14 @@ void MUI_ElementCheckEvent(MUI_Updater *updater, MUI_Element *element)
 
                 MUI_UpdaterChangeEvent(updater, element, MUI_HOVERED);
 
-                if (element->mouseDown == false && mouseDown == true && element->clickable == true)
+                if (element->mouseDown == false && updater->mouseDown == true && element->clickable == true)
                 {
                     element->backgroundColor.r /= (Uint8)2;
                     element->backgroundColor.g /= (Uint8)2;
                     element->backgroundColor.b /= (Uint8)2;
                     element->mouseDown = true;
                 }
-                else if (element->mouseDown == true && mouseDown == false)
+                else if (element->mouseDown == true && updater->mouseDown == false)
                 {
                     element->backgroundColor.r *= (Uint8)2;
                     element->backgroundColor.g *= (Uint8)2;
@@ -460,7 +975,7 @@ void MUI_ElementCheckEvent(MUI_Updater *updater, MUI_Element *element)
                     element->mouseDown = false;
                 }
 
-                if (mouseUp && updater->hoveredElement == element && updater->draggedElement == nullptr && updater->clickedElement == nullptr && element->clickable == true)
+                if (updater->mouseUp && updater->hoveredElement == element && updater->draggedElement == nullptr && updater->clickedElement == nullptr && element->clickable == true)
                 {
                     MUI_UpdaterChangeEvent(updater, element, MUI_CLICKED);
 
@@ -476,7 +991,7 @@ void MUI_ElementCheckEvent(MUI_Updater *updater, MUI_Element *element)
                 element->mouseDown = false;
             }
 
-            if (mouseUp && updater->draggedElement != nullptr)
+            if (updater->mouseUp && updater->draggedElement != nullptr)
                 MUI_UpdaterChangeEvent(updater, nullptr, MUI_NOEVENT);
                 
         }
@@ -490,170 +1005,2370 @@ void MUI_ElementCheckEvent(MUI_Updater *updater, MUI_Element *element)
     }
 }
 
-std::vector<MUI_Element*> MUI_ElementEventVector;
-
 void MUI_ElementEventUpdate(MUI_Updater *updater)
 {
-    for (int i = MUI_ElementEventVector.size() - 1; i >= 0; i--)
-        MUI_ElementCheckEvent(updater, MUI_ElementEventVector[i]);
+    for (int i = updater->eventElements.size() - 1; i >= 0; i--)
+        MUI_ElementCheckEvent(updater, updater->eventElements[i]);
 }
 
-void MUI_RecursiveCopy(SDL_Renderer *renderer, MUI_Updater *updater, std::vector<MUI_Element*> elements)
-{
+// SOFTWARE BACKEND //
 
-    for (int64_t i = 0;  i < elements.size();  i++)
-    {
-        MUI_Element *element = elements[i];
-        if (element->visible)
-        {
-            SDL_SetRenderDrawColor(renderer, element->backgroundColor.r, element->backgroundColor.g, element->backgroundColor.b, element->backgroundColor.a);
-            SDL_RenderFillRect(renderer, &element->destRect);
-            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-            
-            if (element->srcRect != &element->destRect)
-                SDL_RenderCopy(renderer, element->texture, NULL, &element->destRect);
-            else
-            {
-                int textureW;
-                int textureH;
+// CPU renderer for machines without a GPU. Element drawing is recorded as fill and copy commands, binned
+// into screen tiles and only tiles whose commands changed since the last frame are rasterized, in parallel,
+// then uploaded into one streaming texture. Copies read the ARGB8888 surfaces MUI keeps for text.
 
-                SDL_QueryTexture(element->texture, nullptr, nullptr, &textureW, &textureH);
+#define MUI_SOFTWARE_TILE_SIZE 64
 
-                SDL_Rect destRect = element->destRect;
-                //srcRect.w = (int)(((float)element->destRect.h / (float)textureH + (float)element->destRect.w / (float)textureW) * (float)textureW);
-                //srcRect.h = (int)(((float)element->destRect.h / (float)textureH + (float)element->destRect.w / (float)textureW) * (float)textureH);
+class MUI_ThreadPool
+{
+public:
+    std::vector<std::thread> threads;
+
+    std::mutex              mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+
+    std::function<void(int)> job;
+    int              jobCount   = 0;
+    std::atomic<int> next       {0};
+    int              active     = 0;
+    Uint64           generation = 0;
+    bool             stop       = false;
+};
 
-                float ratio = (float)textureW / (float)textureH;
+void MUI_ThreadPoolWorker(MUI_ThreadPool *pool)
+{
+    Uint64 seen = 0;
 
-                float clampedW = SDL_clamp(textureW, 1, element->destRect.w);
-                float clampedH = SDL_clamp(textureH, 1, element->destRect.h);
+    for (;;)
+    {
+        std::unique_lock<std::mutex> lock(pool->mutex);
+        pool->wake.wait(lock, [pool, seen]() { return pool->stop || pool->generation != seen; });
 
-                float diffW = ((float)textureW - clampedW);
-                float diffH = ((float)textureH - clampedH);
+        if (pool->stop)
+            return;
 
-                float diffA = (float)(diffW + diffH) / 16.0f;
+        seen = pool->generation;
+        lock.unlock();
 
-                float newWidth = clampedW - diffA;
-                float newHeight = clampedH - diffA;
+        for (int i = pool->next.fetch_add(1); i < pool->jobCount; i = pool->next.fetch_add(1))
+            pool->job(i);
 
-                // SDL RECT CAUSES PIXELATED TEXT //
+        lock.lock();
 
-                if (newHeight * ratio > element->destRect.w)
-                {
-                    newWidth = SDL_roundf((float)(SDL_roundf(newWidth)) / 10.0f) * 10.0f;
-                    destRect.w = SDL_roundf(newWidth);
-                    destRect.h = SDL_roundf((float)newWidth / ratio);
-                }
-                else
-                {
-                    newHeight = SDL_roundf((float)(SDL_roundf(newHeight)) / 10.0f) * 10.0f;
-                    destRect.h = SDL_roundf(newHeight);
-                    destRect.w = SDL_roundf((float)newHeight * ratio);
-                }
+        if (--pool->active == 0)
+            pool->finished.notify_all();
+    }
+}
 
-                float newRatio = (float)destRect.w / (float)destRect.h;
+MUI_ThreadPool *MUI_CreateThreadPool(int threads)
+{
+    MUI_ThreadPool *pool = new MUI_ThreadPool;
 
-                //newWidth = ratio * (int)((float)destRect.w / newRatio);
-                //newHeight = (1.0f / ratio) * (int)((float)destRect.h / (1.0f / newRatio));
+    for (int i = 0; i < threads; i++)
+        pool->threads.emplace_back(MUI_ThreadPoolWorker, pool);
 
-                //std::cout << "TEXTURE: " << textureW << ", " << textureH << " "
-                //          << "RECT:"     << newWidth << ", " << newHeight
-                // << std::endl;
+    return pool;
+}
 
-                //destRect.w = newWidth;
-                //destRect.h = newHeight;
+// Runs job(0) .. job(count - 1) across the pool and the calling thread, returns once all are done.
+void MUI_ThreadPoolRun(MUI_ThreadPool *pool, int count, std::function<void(int)> job)
+{
+    if (count <= 0)
+        return;
 
-                newRatio = (float)destRect.w / (float)destRect.h;
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
 
-                //std::cout << ratio << ", " << newRatio << std::endl;
+        pool->job      = std::move(job);
+        pool->jobCount = count;
+        pool->active   = (int)pool->threads.size();
+        pool->next.store(0);
+        pool->generation++;
+    }
 
-                //destRect.w = textureW;
-                //destRect.h = textureH;
+    pool->wake.notify_all();
 
-                destRect.x += SDL_floorf((element->destRect.w - destRect.w) / 2.0f);
-                destRect.y += SDL_floorf((element->destRect.h - destRect.h) / 2.0f);
+    for (int i = pool->next.fetch_add(1); i < count; i = pool->next.fetch_add(1))
+        pool->job(i);
 
-                SDL_RenderCopy(renderer, element->texture, nullptr, &destRect);
-            }
+    std::unique_lock<std::mutex> lock(pool->mutex);
+    pool->finished.wait(lock, [pool]() { return pool->active == 0; });
+}
 
-            if (element->draggable)
-            {
-                SDL_SetRenderDrawColor(renderer, 0, 0, 0, element->backgroundColor.a);
-                
-                SDL_Rect rect = element->destRect;
-                rect.y -= 10;
-                rect.h  = 10;
-                
-                SDL_RenderFillRect(renderer, &rect);
-            }
+void MUI_DestroyThreadPool(MUI_ThreadPool *pool)
+{
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->stop = true;
+    }
 
-            MUI_ElementUpdatedestRect(element, updater);
+    pool->wake.notify_all();
 
-            MUI_ElementEventVector.push_back(elements[i]);
+    for (std::thread &thread : pool->threads)
+        thread.join();
 
-            if (element->childs.size() > 0)
-                MUI_RecursiveCopy(renderer, updater, element->childs);
-            
-        }
-    }
-    
+    delete pool;
 }
 
-void MUI_Update(MUI_Updater *updater, SDL_Renderer *renderer, SDL_Event event)
+struct MUI_RasterCommand
 {
-    MUI_ElementEventVector = {};
-    updater->event = MUI_NOEVENT;
-    updater->clickedElement = nullptr;
-    updater->hoveredElement = nullptr;
-    
-    mouseUp = false;
-    dragged = false;
-    
+    SDL_Rect     rect;
+    Uint32       color;
+    SDL_Surface *surface;
+};
 
-    switch (event.type)
-    {
-    case SDL_MOUSEBUTTONUP:
-        mouseUp   = true;
-        mouseDown = false;
-        break;
-    case SDL_MOUSEBUTTONDOWN:
-        mouseDown = true;
-        mouseUp   = false;
-        break;
-    case SDL_MOUSEMOTION:
-        SDL_GetMouseState(&updater->mouseX, &updater->mouseY);
-        break;
+class MUI_SoftwareBackend
+{
+public:
+    int width;
+    int height;
+    int tilesX;
+    int tilesY;
 
-    case SDL_WINDOWEVENT:
-        if (event.window.event == SDL_WINDOWEVENT_RESIZED)
-            SDL_GetWindowSize(SDL_RenderGetWindow(renderer), &updater->windowSizeX, &updater->windowSizeY);
-        break;
-    
-    default:
-        break;
-    }
+    std::vector<Uint32> framebuffer;
+    SDL_Texture *texture;
+    Uint32 clearColor;
 
+    std::vector<MUI_RasterCommand>  commands;
+    std::vector<std::vector<int>>   bins;
+    std::vector<Uint64>             tileHashes;
+    std::vector<int>                dirtyTiles;
+    std::vector<MUI_Element*>       deferredDraws;
 
-    MUI_RecursiveCopy(renderer, updater, updater->elements);
+    // Surfaces referenced by the last frame's hashes stay alive so their addresses cannot be reused.
+    std::vector<SDL_Surface*> heldSurfaces;
+    std::vector<SDL_Surface*> frameSurfaces;
 
-    MUI_ElementEventUpdate(updater);
-}
+    MUI_ThreadPool *pool;
+};
 
-int MUI_Init(uint32_t flags)
+void MUI_RasterFill(Uint32 *dst, int count, Uint32 color)
 {
-    int sdlInit = 0;
-    int ttfInit = 0;
+    int i = 0;
 
-    if (!SDL_WasInit(flags))
-        sdlInit = SDL_Init(flags);
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    __m128i color4 = _mm_set1_epi32((int)color);
 
-    if (TTF_WasInit() == 0)
-        ttfInit = TTF_Init();
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_si128((__m128i*)(dst + i), color4);
+#endif
+
+    for (; i < count; i++)
+        dst[i] = color;
+}
+
+// SDL_BLENDMODE_BLEND: rgb = src * a + dst * (1 - a), alpha = a + dst * (1 - a).
+void MUI_RasterBlend(Uint32 *dst, const Uint32 *src, int count)
+{
+    int i = 0;
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    __m128i zero      = _mm_setzero_si128();
+    __m128i full      = _mm_set1_epi16(255);
+    __m128i round     = _mm_set1_epi16(128);
+    __m128i alphaLane = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+    __m128i colorMask = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+
+    for (; i + 2 <= count; i += 2)
+    {
+        __m128i s = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(src + i)), zero);
+        __m128i d = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(dst + i)), zero);
+
+        __m128i a    = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        __m128i srcA = _mm_or_si128(_mm_and_si128(a, colorMask), alphaLane);
+        __m128i invA = _mm_sub_epi16(full, a);
+
+        __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(s, srcA), _mm_mullo_epi16(d, invA)), round);
+        sum = _mm_srli_epi16(_mm_add_epi16(sum, _mm_srli_epi16(sum, 8)), 8);
+
+        _mm_storel_epi64((__m128i*)(dst + i), _mm_packus_epi16(sum, zero));
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        Uint32 s = src[i];
+        Uint32 d = dst[i];
+        Uint32 a = s >> 24;
+        Uint32 out = 0;
+
+        for (int shift = 0; shift < 32; shift += 8)
+        {
+            Uint32 sc = (s >> shift) & 0xFF;
+            Uint32 dc = (d >> shift) & 0xFF;
+            Uint32 c  = sc * ((shift == 24) ? 255 : a) + dc * (255 - a) + 128;
+
+            out |= (((c + (c >> 8)) >> 8) & 0xFF) << shift;
+        }
+
+        dst[i] = out;
+    }
+}
+
+MUI_SoftwareBackend *MUI_CreateSoftwareBackend(int threads)
+{
+    MUI_SoftwareBackend *backend = new MUI_SoftwareBackend;
+
+    backend->width      = 0;
+    backend->height     = 0;
+    backend->tilesX     = 0;
+    backend->tilesY     = 0;
+    backend->texture    = nullptr;
+    backend->clearColor = 0xFF000000;
+    backend->pool       = MUI_CreateThreadPool(SDL_max(threads - 1, 0));
+
+    return backend;
+}
+
+void MUI_SoftwareBackendFill(MUI_SoftwareBackend *backend, SDL_Rect rect, SDL_Color color)
+{
+    if (rect.w > 0 && rect.h > 0)
+        backend->commands.push_back(MUI_RasterCommand{rect, ((Uint32)color.a << 24) | ((Uint32)color.r << 16) | ((Uint32)color.g << 8) | color.b, nullptr});
+}
+
+// Draws the element's surface, converting it to ARGB8888 in place the first time. Text created without keepSurface
+// has nothing to draw from, that is reported once and the surface is kept from the element's next text update on.
+void MUI_SoftwareBackendCopy(MUI_SoftwareBackend *backend, MUI_Element *element, SDL_Rect rect)
+{
+    if (element->surface == nullptr)
+    {
+        if (element->texture != nullptr && !element->keepSurface)
+        {
+            std::cout << "MUI TEXT ELEMENT HAS NO SURFACE FOR THE SOFTWARE BACKEND, CREATE IT WITH keepSurface" << std::endl;
+            element->keepSurface = true;
+        }
+
+        return;
+    }
+
+    if (rect.w <= 0 || rect.h <= 0)
+        return;
+
+    element->surface = MUI_ConvertSurface(element->surface);
+
+    if (element->surface != nullptr)
+        backend->commands.push_back(MUI_RasterCommand{rect, 0, element->surface});
+}
+
+void MUI_SoftwareBackendRasterTile(MUI_SoftwareBackend *backend, int tile)
+{
+    SDL_Rect tileRect = {(tile % backend->tilesX) * MUI_SOFTWARE_TILE_SIZE, (tile / backend->tilesX) * MUI_SOFTWARE_TILE_SIZE, 0, 0};
+    tileRect.w = SDL_min(MUI_SOFTWARE_TILE_SIZE, backend->width  - tileRect.x);
+    tileRect.h = SDL_min(MUI_SOFTWARE_TILE_SIZE, backend->height - tileRect.y);
+
+    Uint32 *pixels = backend->framebuffer.data() + tileRect.y * backend->width + tileRect.x;
+    Uint32 row[MUI_SOFTWARE_TILE_SIZE];
+
+    for (int y = 0; y < tileRect.h; y++)
+        MUI_RasterFill(pixels + y * backend->width, tileRect.w, backend->clearColor);
+
+    for (int index : backend->bins[tile])
+    {
+        MUI_RasterCommand *command = &backend->commands[index];
+        SDL_Rect area;
+
+        if (!SDL_IntersectRect(&command->rect, &tileRect, &area))
+            continue;
+
+        for (int y = area.y; y < area.y + area.h; y++)
+        {
+            Uint32 *dst = backend->framebuffer.data() + y * backend->width + area.x;
+
+            if (command->surface == nullptr)
+            {
+                MUI_RasterFill(dst, area.w, command->color);
+                continue;
+            }
+
+            // Nearest neighbour, like SDL's default scale quality.
+            SDL_Surface *surface = command->surface;
+            int sy = (int)((Sint64)(y - command->rect.y) * surface->h / command->rect.h);
+            const Uint32 *src = (const Uint32*)((const Uint8*)surface->pixels + sy * surface->pitch);
+
+            for (int x = 0; x < area.w; x++)
+                row[x] = src[(Sint64)(area.x + x - command->rect.x) * surface->w / command->rect.w];
+
+            MUI_RasterBlend(dst, row, area.w);
+        }
+    }
+}
+
+// Rasterizes the recorded frame and draws it to the renderer, call after MUI_Update and MUI_RenderDragLate and
+// before SDL_RenderPresent. Custom Draw callbacks run afterwards through the renderer, on top of the elements.
+void MUI_SoftwareBackendPresent(MUI_Updater *updater, SDL_Renderer *renderer)
+{
+    MUI_SoftwareBackend *backend = updater->backend;
+
+    if (backend == nullptr)
+        return;
+
+    if (backend->width != updater->windowSizeX || backend->height != updater->windowSizeY || backend->texture == nullptr)
+    {
+        if (backend->texture != nullptr)
+            SDL_DestroyTexture(backend->texture);
+
+        backend->width   = SDL_max(updater->windowSizeX, 1);
+        backend->height  = SDL_max(updater->windowSizeY, 1);
+        backend->tilesX  = (backend->width  + MUI_SOFTWARE_TILE_SIZE - 1) / MUI_SOFTWARE_TILE_SIZE;
+        backend->tilesY  = (backend->height + MUI_SOFTWARE_TILE_SIZE - 1) / MUI_SOFTWARE_TILE_SIZE;
+        backend->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, backend->width, backend->height);
+
+        backend->framebuffer.assign((size_t)backend->width * backend->height, backend->clearColor);
+        backend->bins.assign(backend->tilesX * backend->tilesY, std::vector<int>());
+
+        // Nothing hashes to this, so every tile is drawn on the first frame.
+        backend->tileHashes.assign(backend->tilesX * backend->tilesY, 0);
+    }
+
+    SDL_Rect screen = {0, 0, backend->width, backend->height};
+
+    for (std::vector<int> &bin : backend->bins)
+        bin.clear();
+
+    backend->frameSurfaces.clear();
+
+    for (int i = 0; i < (int)backend->commands.size(); i++)
+    {
+        SDL_Rect area;
+
+        if (!SDL_IntersectRect(&backend->commands[i].rect, &screen, &area))
+            continue;
+
+        if (backend->commands[i].surface != nullptr)
+            backend->frameSurfaces.push_back(backend->commands[i].surface);
+
+        for (int ty = area.y / MUI_SOFTWARE_TILE_SIZE; ty <= (area.y + area.h - 1) / MUI_SOFTWARE_TILE_SIZE; ty++)
+            for (int tx = area.x / MUI_SOFTWARE_TILE_SIZE; tx <= (area.x + area.w - 1) / MUI_SOFTWARE_TILE_SIZE; tx++)
+                backend->bins[ty * backend->tilesX + tx].push_back(i);
+    }
+
+    backend->dirtyTiles.clear();
+
+    for (int tile = 0; tile < (int)backend->bins.size(); tile++)
+    {
+        Uint64 hash = 14695981039346656037ull;
+
+        for (int index : backend->bins[tile])
+        {
+            MUI_RasterCommand *command = &backend->commands[index];
+            Uint64 fields[6] = {(Uint64)(Uint32)command->rect.x, (Uint64)(Uint32)command->rect.y, (Uint64)(Uint32)command->rect.w,
+                                (Uint64)(Uint32)command->rect.h, command->color, (Uint64)(uintptr_t)command->surface};
+
+            for (Uint64 field : fields)
+                hash = (hash ^ field) * 1099511628211ull;
+        }
+
+        hash |= 1;
+
+        if (hash != backend->tileHashes[tile])
+        {
+            backend->tileHashes[tile] = hash;
+            backend->dirtyTiles.push_back(tile);
+        }
+    }
+
+    if (!backend->dirtyTiles.empty())
+        MUI_ThreadPoolRun(backend->pool, (int)backend->dirtyTiles.size(), [backend](int i)
+        {
+            MUI_SoftwareBackendRasterTile(backend, backend->dirtyTiles[i]);
+        });
+
+    for (int tile : backend->dirtyTiles)
+    {
+        SDL_Rect tileRect = {(tile % backend->tilesX) * MUI_SOFTWARE_TILE_SIZE, (tile / backend->tilesX) * MUI_SOFTWARE_TILE_SIZE, 0, 0};
+        tileRect.w = SDL_min(MUI_SOFTWARE_TILE_SIZE, backend->width  - tileRect.x);
+        tileRect.h = SDL_min(MUI_SOFTWARE_TILE_SIZE, backend->height - tileRect.y);
+
+        SDL_UpdateTexture(backend->texture, &tileRect, backend->framebuffer.data() + tileRect.y * backend->width + tileRect.x, backend->width * 4);
+    }
+
+    SDL_RenderCopy(renderer, backend->texture, nullptr, nullptr);
+
+    for (MUI_Element *element : backend->deferredDraws)
+        element->Draw(renderer, element);
+
+    for (SDL_Surface *surface : backend->frameSurfaces)
+        surface->refcount++;
+
+    for (SDL_Surface *surface : backend->heldSurfaces)
+        SDL_FreeSurface(surface);
+
+    backend->heldSurfaces.swap(backend->frameSurfaces);
+    backend->commands.clear();
+    backend->deferredDraws.clear();
+}
+
+void MUI_DestroySoftwareBackend(MUI_SoftwareBackend *backend)
+{
+    for (SDL_Surface *surface : backend->heldSurfaces)
+        SDL_FreeSurface(surface);
+
+    if (backend->texture != nullptr)
+        SDL_DestroyTexture(backend->texture);
+
+    MUI_DestroyThreadPool(backend->pool);
+
+    delete backend;
+}
+
+void MUI_ProfilerAddDragLatency(MUI_Profiler *profiler, Uint64 sampleCounter)
+{
+    profiler->dragLatency = (float)((double)(SDL_GetPerformanceCounter() - sampleCounter) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+    profiler->dragLatencySamples++;
+    profiler->dragLatencyAverage += (profiler->dragLatency - profiler->dragLatencyAverage) / (float)profiler->dragLatencySamples;
+}
+
+void MUI_ElementRender(SDL_Renderer *renderer, MUI_Element *element, MUI_SoftwareBackend *backend = nullptr)
+{
+    if (backend != nullptr)
+        MUI_SoftwareBackendFill(backend, element->destRect, element->backgroundColor);
+    else
+    {
+        SDL_SetRenderDrawColor(renderer, element->backgroundColor.r, element->backgroundColor.g, element->backgroundColor.b, element->backgroundColor.a);
+        SDL_RenderFillRect(renderer, &element->destRect);
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    }
+    
+    if (element->srcRect != &element->destRect)
+    {
+        if (element->texture != nullptr)
+        {
+            if (backend != nullptr)
+                MUI_SoftwareBackendCopy(backend, element, element->destRect);
+            else
+                SDL_RenderCopy(renderer, element->texture, NULL, &element->destRect);
+        }
+    }
+    else if (element->texture != nullptr)
+    {
+        int textureW = 0;
+        int textureH = 0;
+
+        if (SDL_QueryTexture(element->texture, nullptr, nullptr, &textureW, &textureH) == 0 && textureW > 0 && textureH > 0)
+        {
+            SDL_Rect destRect = element->destRect;
+            //srcRect.w = (int)(((float)element->destRect.h / (float)textureH + (float)element->destRect.w / (float)textureW) * (float)textureW);
+            //srcRect.h = (int)(((float)element->destRect.h / (float)textureH + (float)element->destRect.w / (float)textureW) * (float)textureH);
+
+            float ratio = (float)textureW / (float)textureH;
+
+            float clampedW = SDL_clamp(textureW, 1, element->destRect.w);
+            float clampedH = SDL_clamp(textureH, 1, element->destRect.h);
+
+            float diffW = ((float)textureW - clampedW);
+            float diffH = ((float)textureH - clampedH);
+
+            float diffA = (float)(diffW + diffH) / 16.0f;
+
+            float newWidth = clampedW - diffA;
+            float newHeight = clampedH - diffA;
+
+            // SDL RECT CAUSES PIXELATED TEXT //
+
+            if (newHeight * ratio > element->destRect.w)
+            {
+                newWidth = SDL_roundf((float)(SDL_roundf(newWidth)) / 10.0f) * 10.0f;
+                destRect.w = SDL_roundf(newWidth);
+                destRect.h = SDL_roundf((float)newWidth / ratio);
+            }
+            else
+            {
+                newHeight = SDL_roundf((float)(SDL_roundf(newHeight)) / 10.0f) * 10.0f;
+                destRect.h = SDL_roundf(newHeight);
+                destRect.w = SDL_roundf((float)newHeight * ratio);
+            }
+
+            float newRatio = (float)destRect.w / (float)destRect.h;
+
+            //newWidth = ratio * (int)((float)destRect.w / newRatio);
+            //newHeight = (1.0f / ratio) * (int)((float)destRect.h / (1.0f / newRatio));
+
+            //std::cout << "TEXTURE: " << textureW << ", " << textureH << " "
+            //          << "RECT:"     << newWidth << ", " << newHeight
+            // << std::endl;
+
+            //destRect.w = newWidth;
+            //destRect.h = newHeight;
+
+            newRatio = (float)destRect.w / (float)destRect.h;
+
+            //std::cout << ratio << ", " << newRatio << std::endl;
+
+            //destRect.w = textureW;
+            //destRect.h = textureH;
+
+            destRect.x += SDL_floorf((element->destRect.w - destRect.w) / 2.0f);
+            destRect.y += SDL_floorf((element->destRect.h - destRect.h) / 2.0f);
+
+            if (backend != nullptr)
+                MUI_SoftwareBackendCopy(backend, element, destRect);
+            else
+                SDL_RenderCopy(renderer, element->texture, nullptr, &destRect);
+        }
+    }
+
+    if (element->Draw != nullptr)
+    {
+        if (backend != nullptr)
+            backend->deferredDraws.push_back(element);
+        else
+            element->Draw(renderer, element);
+    }
+
+    if (element->draggable)
+    {
+        SDL_Rect rect = element->destRect;
+        rect.y -= 10;
+        rect.h  = 10;
+
+        if (backend != nullptr)
+            MUI_SoftwareBackendFill(backend, rect, SDL_Color{0, 0, 0, element->backgroundColor.a});
+        else
+        {
+            SDL_SetRenderDrawColor(renderer, 0, 0, 0, element->backgroundColor.a);
+            SDL_RenderFillRect(renderer, &rect);
+        }
+    }
+}
+
+void MUI_RecursiveCopy(SDL_Renderer *renderer, MUI_Updater *updater, const std::vector<MUI_Element*> &elements, bool draw = true)
+{
+    for (int64_t i = 0;  i < elements.size();  i++)
+    {
+        MUI_Element *element = elements[i];
+        if (element->visible)
+        {
+            bool drawElement = draw;
+
+            if (drawElement && element == updater->draggedElement && updater->lowLatencyDrag)
+            {
+                updater->deferredElement = element;
+                drawElement = false;
+            }
+
+            if (drawElement)
+            {
+                MUI_ElementRender(renderer, element, updater->backend);
+
+                if (element == updater->draggedElement && updater->dragRectCounter != 0)
+                {
+                    MUI_ProfilerAddDragLatency(&updater->profiler, updater->dragRectCounter);
+                    updater->dragRectCounter = 0;
+                }
+            }
+
+            MUI_ElementLayout(element, updater);
+
+            if (element == updater->draggedElement && updater->dragPositionCounter != updater->dragAppliedCounter)
+            {
+                updater->dragRectCounter    = updater->dragPositionCounter;
+                updater->dragAppliedCounter = updater->dragPositionCounter;
+            }
+
+            if (element->layout != MUI_LAYOUT_NONE)
+                MUI_ElementArrange(element);
+
+            updater->eventElements.push_back(elements[i]);
+
+            if (element->childs.size() > 0)
+                MUI_RecursiveCopy(renderer, updater, element->childs, drawElement);
+            
+        }
+    }
+}
+
+// DATA BINDING //
+
+template <typename T>
+bool MUI_ValueEquals(const T &a, const T &b)
+{
+    return a == b;
+}
+
+bool MUI_ValueEquals(const SDL_Color &a, const SDL_Color &b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+bool MUI_ValueEquals(const MUI_Vector2 &a, const MUI_Vector2 &b)
+{
+    return a.X == b.X && a.Y == b.Y;
+}
+
+// A value cell, Set bumps version only when the value actually changes.
+template <typename T>
+class MUI_Observable
+{
+public:
+    T      value;
+    Uint64 version;
+
+    void Set(const T &newValue)
+    {
+        if (!MUI_ValueEquals(this->value, newValue))
+        {
+            this->value = newValue;
+            this->version++;
+        }
+    }
+
+    const T &Get() const
+    {
+        return this->value;
+    }
+
+    MUI_Observable(const T &value) : value(value), version(0) {}
+
+    MUI_Observable() : value(), version(0) {}
+};
+
+class MUI_Binding
+{
+public:
+    MUI_Element *element;
+
+    virtual void Update(SDL_Renderer *renderer) = 0;
+
+    virtual ~MUI_Binding() {}
+};
+
+template <typename T>
+class MUI_ValueBinding : public MUI_Binding
+{
+public:
+    MUI_Observable<T> *observable;
+    Uint64 version;
+
+    std::function<void(SDL_Renderer*, const T&)> Apply;
+
+    void Update(SDL_Renderer *renderer) override
+    {
+        if (this->observable->version != this->version)
+        {
+            this->version = this->observable->version;
+            this->Apply(renderer, this->observable->value);
+        }
+    }
+};
+
+// Runs apply once on the next MUI_Update and again only on frames where observable's version moved.
+// The observable must outlive the binding, remove it with MUI_Unbind before destroying either.
+template <typename T>
+MUI_Binding *MUI_Bind(MUI_Updater *updater, MUI_Element *element, MUI_Observable<T> *observable, std::function<void(SDL_Renderer*, const T&)> apply)
+{
+    MUI_ValueBinding<T> *binding = new MUI_ValueBinding<T>;
+
+    binding->element    = element;
+    binding->observable = observable;
+    binding->version    = observable->version - 1;
+    binding->Apply      = apply;
+
+    updater->bindings.push_back(binding);
+
+    return binding;
+}
+
+template <typename T>
+MUI_Binding *MUI_BindText(MUI_Updater *updater, MUI_Element *element, MUI_Observable<T> *observable, TTF_Font *font, SDL_Color textColor, std::function<std::string(const T&)> format)
+{
+    std::string text;
+
+    return MUI_Bind<T>(updater, element, observable, [element, font, textColor, format, text](SDL_Renderer *renderer, const T &value) mutable
+    {
+        std::string newText = format(value);
+
+        if (newText != text)
+        {
+            text = newText;
+            MUI_UpdateText(renderer, element, text.c_str(), font, textColor);
+        }
+    });
+}
+
+MUI_Binding *MUI_BindBackgroundColor(MUI_Updater *updater, MUI_Element *element, MUI_Observable<SDL_Color> *observable)
+{
+    return MUI_Bind<SDL_Color>(updater, element, observable, [element](SDL_Renderer *, const SDL_Color &value)
+    {
+        element->backgroundColor = value;
+    });
+}
+
+MUI_Binding *MUI_BindPosition(MUI_Updater *updater, MUI_Element *element, MUI_Observable<MUI_Vector2> *observable)
+{
+    return MUI_Bind<MUI_Vector2>(updater, element, observable, [element](SDL_Renderer *, const MUI_Vector2 &value)
+    {
+        element->position = value;
+    });
+}
+
+// Removes and deletes every binding attached to element.
+void MUI_Unbind(MUI_Updater *updater, MUI_Element *element)
+{
+    for (size_t i = 0; i < updater->bindings.size();)
+    {
+        if (updater->bindings[i]->element == element)
+        {
+            delete updater->bindings[i];
+            updater->bindings.erase(updater->bindings.begin() + i);
+        }
+        else
+            i++;
+    }
+}
+
+void MUI_BindingsUpdate(MUI_Updater *updater, SDL_Renderer *renderer)
+{
+    for (MUI_Binding *binding : updater->bindings)
+        binding->Update(renderer);
+}
+
+void MUI_Update(MUI_Updater *updater, SDL_Renderer *renderer, SDL_Event event)
+{
+    Uint64 frameStart = SDL_GetPerformanceCounter();
+
+    updater->eventElements.clear();
+    updater->event = MUI_NOEVENT;
+    updater->clickedElement = nullptr;
+    updater->hoveredElement = nullptr;
+    
+    updater->mouseUp = false;
+    updater->dragged = false;
+    
+
+    switch (event.type)
+    {
+    case SDL_MOUSEBUTTONUP:
+        updater->mouseUp   = true;
+        updater->mouseDown = false;
+        break;
+    case SDL_MOUSEBUTTONDOWN:
+        updater->mouseDown = true;
+        updater->mouseUp   = false;
+        break;
+    case SDL_MOUSEMOTION:
+        SDL_GetMouseState(&updater->mouseX, &updater->mouseY);
+        updater->mouseCounter = frameStart;
+        break;
+
+    case SDL_WINDOWEVENT:
+        if (event.window.event == SDL_WINDOWEVENT_RESIZED)
+            SDL_GetWindowSize(SDL_RenderGetWindow(renderer), &updater->windowSizeX, &updater->windowSizeY);
+        break;
+    
+    default:
+        break;
+    }
+
+
+    MUI_BindingsUpdate(updater, renderer);
+
+    MUI_RecursiveCopy(renderer, updater, updater->elements);
+
+    MUI_ElementEventUpdate(updater);
+
+    if (updater->draggedElement == nullptr)
+    {
+        updater->dragRectCounter    = 0;
+        updater->dragAppliedCounter = 0;
+        updater->dragLastCounter    = 0;
+    }
+
+    updater->profiler.frameTime = (float)((double)(SDL_GetPerformanceCounter() - frameStart) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+}
+
+// Lays the tree out without drawing it, so the next MUI_Update draws every element with its current rect.
+void MUI_UpdateLayout(MUI_Updater *updater, SDL_Renderer *renderer)
+{
+    MUI_BindingsUpdate(updater, renderer);
+    MUI_RecursiveCopy(renderer, updater, updater->elements, false);
+
+    updater->eventElements.clear();
+}
+
+void MUI_ElementTranslate(MUI_Element *element, int x, int y)
+{
+    element->destRect.x += x;
+    element->destRect.y += y;
+
+    for (MUI_Element *child : element->childs)
+        MUI_ElementTranslate(child, x, y);
+}
+
+void MUI_RecursiveRender(SDL_Renderer *renderer, MUI_Element *element, MUI_SoftwareBackend *backend = nullptr)
+{
+    if (element->visible)
+    {
+        MUI_ElementRender(renderer, element, backend);
+
+        for (MUI_Element *child : element->childs)
+            MUI_RecursiveRender(renderer, child, backend);
+    }
+}
+
+// Call between MUI_Update and SDL_RenderPresent when lowLatencyDrag is set, MUI_Update leaves the dragged subtree
+// undrawn. Pumps events and samples the mouse again, moves the subtree's cached rects to it without a relayout and
+// draws it on top. SDL_PumpEvents must run on the thread that created the window, so call this from the main thread.
+void MUI_RenderDragLate(MUI_Updater *updater, SDL_Renderer *renderer)
+{
+    MUI_Element *element = updater->deferredElement;
+
+    if (element == nullptr)
+        return;
+
+    updater->deferredElement = nullptr;
+
+    if (element != updater->draggedElement || updater->event != MUI_DRAGGED)
+    {
+        MUI_RecursiveRender(renderer, element, updater->backend);
+        return;
+    }
+
+    int mouseX;
+    int mouseY;
+
+    // SDL_GetMouseState only reports what the last pump saw, without this it is the position MUI_Update already used.
+    SDL_PumpEvents();
+    SDL_GetMouseState(&mouseX, &mouseY);
+
+    Uint64 counter = SDL_GetPerformanceCounter();
+
+    if (updater->dragLastCounter != 0 && counter != updater->dragLastCounter)
+    {
+        float elapsed = (float)((double)(counter - updater->dragLastCounter) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+
+        updater->dragVelocityX += ((float)(mouseX - updater->dragLastX) / elapsed - updater->dragVelocityX) * 0.5f;
+        updater->dragVelocityY += ((float)(mouseY - updater->dragLastY) / elapsed - updater->dragVelocityY) * 0.5f;
+    }
+    else
+    {
+        updater->dragVelocityX = 0.0f;
+        updater->dragVelocityY = 0.0f;
+    }
+
+    updater->dragLastCounter = counter;
+    updater->dragLastX       = mouseX;
+    updater->dragLastY       = mouseY;
+
+    float targetX = (float)mouseX + updater->dragVelocityX * updater->dragPrediction;
+    float targetY = (float)mouseY + updater->dragVelocityY * updater->dragPrediction;
+
+    // Same anchor MUI_ElementCheckEvent uses, the bar above the element is centered on the cursor.
+    int x = (int)targetX - element->destRect.w / 2;
+    int y = (int)targetY + ((element->scaling == MUI_SCALING_OFFSET) ? -5 : 5);
+
+    bool moved = x != element->destRect.x || y != element->destRect.y;
+
+    MUI_ElementTranslate(element, x - element->destRect.x, y - element->destRect.y);
+    MUI_RecursiveRender(renderer, element, updater->backend);
+
+    if (moved)
+        MUI_ProfilerAddDragLatency(&updater->profiler, counter);
+}
+
+int MUI_Init(uint32_t flags)
+{
+    int sdlInit = 0;
+    int ttfInit = 0;
+
+    if (!SDL_WasInit(flags))
+        sdlInit = SDL_Init(flags);
+
+    if (TTF_WasInit() == 0)
+        ttfInit = TTF_Init();
 
     if (sdlInit == -1)
         std::cout << "MUI FAILED INITILIAZING SDL." << std::endl;
     if (ttfInit == -1)
         std::cout << "MUI FAILED INITILIAZING TTF." << std::endl;
 
-    return ttfInit && sdlInit;
-}
\ No newline at end of file
+    return ttfInit && sdlInit;
+}
+
+// TRACE RECORD / REPLAY //
+
+#define MUI_TRACE_MAGIC   0x5449554D
+#define MUI_TRACE_VERSION 2
+
+struct MUI_TraceHeader
+{
+    Uint32 magic;
+    Uint32 version;
+    Sint32 windowSizeX;
+    Sint32 windowSizeY;
+    Sint32 mouseX;
+    Sint32 mouseY;
+    Uint32 mouseDown;
+};
+
+// One record per MUI_Update call, frameTime is the time since the previous record in microseconds.
+// The mouse position and window size are the values MUI_Update sampled for that frame.
+struct MUI_TraceRecord
+{
+    Uint32 frameTime;
+    Uint32 type;
+    Sint32 mouseX;
+    Sint32 mouseY;
+    Sint32 windowSizeX;
+    Sint32 windowSizeY;
+};
+
+class MUI_TraceRecorder
+{
+public:
+    std::ofstream file;
+    Uint64 lastCounter;
+    Uint32 frames;
+};
+
+class MUI_TraceReplay
+{
+public:
+    bool loaded;
+
+    std::vector<float> recordedFrameTimes;
+    std::vector<float> frameTimes;
+
+    std::string finalState;
+};
+
+MUI_TraceRecorder *MUI_CreateTraceRecorder(const char *path, MUI_Updater *updater)
+{
+    MUI_TraceRecorder *recorder = new MUI_TraceRecorder;
+
+    recorder->file.open(path, std::ios::binary | std::ios::trunc);
+
+    if (!recorder->file.is_open())
+    {
+        std::cout << "MUI FAILED OPENING TRACE " << path << std::endl;
+        delete recorder;
+        return nullptr;
+    }
+
+    MUI_TraceHeader header = {MUI_TRACE_MAGIC, MUI_TRACE_VERSION, updater->windowSizeX, updater->windowSizeY,
+                              updater->mouseX, updater->mouseY, updater->mouseDown};
+    recorder->file.write((const char*)&header, sizeof(header));
+
+    recorder->lastCounter = SDL_GetPerformanceCounter();
+    recorder->frames      = 0;
+
+    return recorder;
+}
+
+// Call once per frame after MUI_Update, with the same event passed to it.
+void MUI_TraceRecordEvent(MUI_TraceRecorder *recorder, MUI_Updater *updater, SDL_Event event)
+{
+    Uint64 counter = SDL_GetPerformanceCounter();
+
+    MUI_TraceRecord record = {};
+    record.frameTime   = (Uint32)(((counter - recorder->lastCounter) * 1000000) / SDL_GetPerformanceFrequency());
+    recorder->lastCounter = counter;
+
+    record.mouseX      = updater->mouseX;
+    record.mouseY      = updater->mouseY;
+    record.windowSizeX = updater->windowSizeX;
+    record.windowSizeY = updater->windowSizeY;
+
+    switch (event.type)
+    {
+    case SDL_MOUSEBUTTONUP:
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEMOTION:
+        record.type = event.type;
+        break;
+    case SDL_WINDOWEVENT:
+        if (event.window.event == SDL_WINDOWEVENT_RESIZED)
+            record.type = event.type;
+        break;
+
+    default:
+        break;
+    }
+
+    recorder->file.write((const char*)&record, sizeof(record));
+    recorder->frames++;
+}
+
+void MUI_DestroyTraceRecorder(MUI_TraceRecorder *recorder)
+{
+    recorder->file.close();
+
+    delete recorder;
+}
+
+void MUI_ElementDumpState(std::ostream &out, MUI_Element *element, int depth)
+{
+    out << std::string(depth * 2, ' ')
+        << element->destRect.x << ' ' << element->destRect.y << ' ' << element->destRect.w << ' ' << element->destRect.h << ' '
+        << element->position.X << ' ' << element->position.Y << ' '
+        << element->visible    << ' ' << element->mouseDown
+        << '\n';
+
+    for (MUI_Element *child : element->childs)
+        MUI_ElementDumpState(out, child, depth + 1);
+}
+
+std::string MUI_UpdaterDumpState(MUI_Updater *updater)
+{
+    std::ostringstream out;
+
+    out << updater->windowSizeX << ' ' << updater->windowSizeY << ' ' << updater->mouseX << ' ' << updater->mouseY << '\n';
+
+    for (MUI_Element *element : updater->elements)
+        MUI_ElementDumpState(out, element, 0);
+
+    return out.str();
+}
+
+// Feeds a recorded trace through MUI_Update as fast as possible. The renderer does not need a window,
+// a software renderer from SDL_CreateSoftwareRenderer is enough to run headless.
+MUI_TraceReplay MUI_ReplayTrace(const char *path, MUI_Updater *updater, SDL_Renderer *renderer)
+{
+    MUI_TraceReplay replay;
+    replay.loaded = false;
+
+    std::ifstream file(path, std::ios::binary);
+    MUI_TraceHeader header;
+
+    if (!file.read((char*)&header, sizeof(header)) || header.magic != MUI_TRACE_MAGIC || header.version != MUI_TRACE_VERSION)
+    {
+        std::cout << "MUI FAILED READING TRACE " << path << std::endl;
+        return replay;
+    }
+
+    updater->windowSizeX = header.windowSizeX;
+    updater->windowSizeY = header.windowSizeY;
+    updater->mouseX      = header.mouseX;
+    updater->mouseY      = header.mouseY;
+    updater->mouseDown   = header.mouseDown != 0;
+    updater->mouseUp     = false;
+
+    MUI_TraceRecord record;
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+
+    while (file.read((char*)&record, sizeof(record)))
+    {
+        // Motion and resize are applied from the record, MUI_Update would otherwise query the live mouse and window.
+        SDL_Event event = {};
+
+        updater->mouseX      = record.mouseX;
+        updater->mouseY      = record.mouseY;
+        updater->windowSizeX = record.windowSizeX;
+        updater->windowSizeY = record.windowSizeY;
+
+        Uint64 start = SDL_GetPerformanceCounter();
+
+        switch (record.type)
+        {
+        case SDL_MOUSEBUTTONUP:
+        case SDL_MOUSEBUTTONDOWN:
+            event.type = record.type;
+            break;
+        case SDL_MOUSEMOTION:
+            updater->mouseCounter = start;
+            break;
+
+        default:
+            break;
+        }
+
+        SDL_RenderClear(renderer);
+        MUI_Update(updater, renderer, event);
+
+        Uint64 end = SDL_GetPerformanceCounter();
+
+        replay.recordedFrameTimes.push_back((float)record.frameTime / 1000.0f);
+        replay.frameTimes.push_back((float)((double)(end - start) * 1000.0 / (double)frequency));
+    }
+
+    replay.finalState = MUI_UpdaterDumpState(updater);
+    replay.loaded     = true;
+
+    return replay;
+}
+
+// Writes "frame,recorded_ms,replayed_ms" rows followed by the final element state, for diffing against a baseline.
+void MUI_TraceReplayWrite(std::ostream &out, MUI_TraceReplay &replay)
+{
+    out << "frame,recorded_ms,replayed_ms\n";
+
+    for (size_t i = 0; i < replay.frameTimes.size(); i++)
+        out << i << ',' << replay.recordedFrameTimes[i] << ',' << replay.frameTimes[i] << '\n';
+
+    out << "state\n" << replay.finalState;
+}
+
+
+
+// IMMEDIATE MODE //
+
+// Widgets are declared every frame between MUI_ImBegin and MUI_ImEnd and matched to retained elements by a hash
+// of their label and the enclosing panels. Text after "##" only feeds the hash, so "Save##file" and "Save##edit"
+// are different widgets. Elements are only created, changed or destroyed when the declarations differ.
+
+class MUI_ImNode
+{
+public:
+    MUI_Element *element;
+    std::string  text;
+    SDL_Color    backgroundColor;
+    Uint32       lastFrame;
+    bool         clicked;
+};
+
+class MUI_ImContext
+{
+public:
+    MUI_Updater  *updater;
+    SDL_Renderer *renderer;
+    TTF_Font     *font;
+
+    SDL_Color textColor;
+    SDL_Color buttonColor;
+    SDL_Color panelColor;
+
+    MUI_Element *root;
+    Uint32       frame;
+
+    std::unordered_map<Uint32, MUI_ImNode> nodes;
+
+    std::vector<Uint32>       idStack;
+    std::vector<MUI_Element*> parentStack;
+    std::vector<size_t>       cursorStack;
+    std::vector<Uint32>       staleNodes;
+};
+
+Uint32 MUI_ImHash(const char *label, Uint32 seed)
+{
+    Uint32 hash = seed ^ 2166136261u;
+
+    for (const char *c = label; *c != '\0'; c++)
+        hash = (hash ^ (Uint8)*c) * 16777619u;
+
+    return hash;
+}
+
+MUI_ImContext *MUI_CreateImContext(MUI_Updater *updater, SDL_Renderer *renderer, TTF_Font *font)
+{
+    MUI_ImContext *context = new MUI_ImContext;
+
+    context->updater     = updater;
+    context->renderer    = renderer;
+    context->font        = font;
+    context->textColor   = SDL_Color{255, 255, 255, 255};
+    context->buttonColor = SDL_Color{90, 0, 90, 255};
+    context->panelColor  = SDL_Color{50, 0, 50, 255};
+    context->frame       = 0;
+
+    context->root = MUI_CreateFrame(renderer, context->panelColor, MUI_Vector2(0, 0), MUI_Vector2(1, 1), MUI_SCALING_SCALE, MUI_SCALE_XY, false, false);
+    context->root->layout = MUI_LAYOUT_VERTICAL;
+
+    MUI_UpdateCopy(updater, context->root);
+
+    return context;
+}
+
+void MUI_ImBegin(MUI_ImContext *context)
+{
+    context->frame++;
+
+    context->idStack.clear();
+    context->parentStack.clear();
+    context->cursorStack.clear();
+
+    context->idStack.push_back(0);
+    context->parentStack.push_back(context->root);
+    context->cursorStack.push_back(0);
+}
+
+// Finds or creates the node for label and moves its element to the current slot of the open panel.
+MUI_ImNode *MUI_ImDeclare(MUI_ImContext *context, const char *label, bool clickable, bool panel)
+{
+    Uint32 id = MUI_ImHash(label, context->idStack.back());
+
+    const char *idSeparator = strstr(label, "##");
+    size_t textLength = (idSeparator != nullptr) ? (size_t)(idSeparator - label) : strlen(label);
+
+    SDL_Color color = panel ? context->panelColor : context->buttonColor;
+
+    auto found = context->nodes.find(id);
+    MUI_ImNode *node;
+
+    if (found == context->nodes.end())
+    {
+        node = &context->nodes[id];
+        node->text.assign(label, textLength);
+        node->backgroundColor = color;
+        node->clicked         = false;
+
+        bool keepSurface = context->updater->backend != nullptr;
+
+        if (panel || textLength == 0)
+        {
+            node->element = MUI_CreateFrame(context->renderer, color, MUI_Vector2(0, 0), MUI_Vector2(0, 0), MUI_SCALING_SCALE, MUI_SCALE_XY, clickable, false);
+            node->element->keepSurface = keepSurface;
+        }
+        else
+            node->element = MUI_CreateText(context->renderer, node->text.c_str(), context->font, context->textColor, color, MUI_Vector2(0, 0), MUI_Vector2(0, 0), MUI_SCALING_SCALE, MUI_SCALE_XY, clickable, false, keepSurface);
+
+        if (clickable)
+            node->element->Clicked = [node]() { node->clicked = true; };
+    }
+    else
+    {
+        node = &found->second;
+
+        if (!panel && node->text.compare(0, std::string::npos, label, textLength) != 0)
+        {
+            node->text.assign(label, textLength);
+
+            if (textLength == 0)
+            {
+                SDL_DestroyTexture(node->element->texture);
+                SDL_FreeSurface(node->element->surface);
+
+                node->element->texture = nullptr;
+                node->element->surface = nullptr;
+                node->element->srcRect = nullptr;
+
+                MUI_ElementInvalidateLayout(node->element);
+            }
+            else
+            {
+                MUI_UpdateText(context->renderer, node->element, node->text.c_str(), context->font, context->textColor);
+                node->element->srcRect = &node->element->destRect;
+            }
+        }
+
+        if (memcmp(&node->backgroundColor, &color, sizeof(SDL_Color)) != 0)
+        {
+            node->backgroundColor = color;
+            node->element->backgroundColor = color;
+        }
+    }
+
+    node->lastFrame = context->frame;
+
+    MUI_Element *parent = context->parentStack.back();
+    size_t cursor = context->cursorStack.back()++;
+
+    if (node->element->parent != parent)
+        MUI_ElementSetParent(node->element, parent);
+
+    if (cursor >= parent->childs.size() || parent->childs[cursor] != node->element)
+    {
+        auto position = std::find(parent->childs.begin(), parent->childs.end(), node->element);
+
+        parent->childs.erase(position);
+        parent->childs.insert(parent->childs.begin() + SDL_min(cursor, parent->childs.size()), node->element);
+
+        MUI_ElementInvalidateLayout(parent);
+    }
+
+    return node;
+}
+
+bool MUI_ImButton(MUI_ImContext *context, const char *label)
+{
+    MUI_ImNode *node = MUI_ImDeclare(context, label, true, false);
+
+    bool clicked  = node->clicked;
+    node->clicked = false;
+
+    return clicked;
+}
+
+void MUI_ImText(MUI_ImContext *context, const char *label)
+{
+    MUI_ImDeclare(context, label, false, false);
+}
+
+void MUI_ImBeginPanel(MUI_ImContext *context, const char *label, int layout, int columns)
+{
+    MUI_ImNode *node = MUI_ImDeclare(context, label, false, true);
+
+    if (node->element->layout != layout || node->element->layoutColumns != columns)
+    {
+        node->element->layout        = layout;
+        node->element->layoutColumns = columns;
+
+        MUI_ElementInvalidateLayout(node->element);
+    }
+
+    context->idStack.push_back(MUI_ImHash(label, context->idStack.back()));
+    context->parentStack.push_back(node->element);
+    context->cursorStack.push_back(0);
+}
+
+void MUI_ImEndPanel(MUI_ImContext *context)
+{
+    context->idStack.pop_back();
+    context->parentStack.pop_back();
+    context->cursorStack.pop_back();
+}
+
+// Destroys the elements of every widget that was not declared this frame.
+void MUI_ImEnd(MUI_ImContext *context)
+{
+    context->staleNodes.clear();
+
+    for (auto &entry : context->nodes)
+        if (entry.second.lastFrame != context->frame)
+            context->staleNodes.push_back(entry.first);
+
+    MUI_Updater *updater = context->updater;
+
+    for (Uint32 id : context->staleNodes)
+    {
+        MUI_Element *element = context->nodes[id].element;
+
+        if (updater->clickedElement  == element) updater->clickedElement  = nullptr;
+        if (updater->hoveredElement  == element) updater->hoveredElement  = nullptr;
+        if (updater->draggedElement  == element) updater->draggedElement  = nullptr;
+        if (updater->deferredElement == element) updater->deferredElement = nullptr;
+
+        MUI_Unbind(updater, element);
+        MUI_DestroyElement(element);
+        context->nodes.erase(id);
+    }
+}
+
+void MUI_DestroyImContext(MUI_ImContext *context)
+{
+    for (auto &entry : context->nodes)
+        MUI_DestroyElement(entry.second.element);
+
+    context->updater->elements.erase(std::remove(context->updater->elements.begin(), context->updater->elements.end(), context->root), context->updater->elements.end());
+
+    MUI_DestroyElement(context->root);
+
+    delete context;
+}
+
+
+
+// TILED IMAGE //
+
+// .mti layout: MUI_TiledImageHeader, then every level from full resolution down, each level's tiles in row
+// order. A tile is tileSize * tileSize ARGB8888 pixels, edge tiles are zero padded, so offsets need no table.
+
+#define MUI_TILED_IMAGE_MAGIC   0x49544D4D
+#define MUI_TILED_IMAGE_VERSION 1
+
+struct MUI_TiledImageHeader
+{
+    Uint32 magic;
+    Uint32 version;
+    Uint32 width;
+    Uint32 height;
+    Uint32 tileSize;
+    Uint32 levels;
+};
+
+class MUI_TiledImageTile
+{
+public:
+    Uint64       key;
+    SDL_Texture *texture;
+    Uint32       lastFrame;
+};
+
+class MUI_TiledImage
+{
+public:
+    MUI_Element *element;
+
+    MUI_TiledImageHeader header;
+    std::vector<size_t>  levelOffsets;
+
+    const Uint8 *data;
+    size_t       dataSize;
+
+#if defined(_WIN32)
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int file;
+#endif
+
+    // View, the source pixel shown at the element's top left corner and screen pixels per source pixel.
+    // A zoom of 0 fits the whole image on the next draw.
+    float viewX;
+    float viewY;
+    float zoom;
+
+    float lastViewX;
+    float lastViewY;
+    float lastZoom;
+
+    // Least recently used tiles at the back.
+    std::list<MUI_TiledImageTile> tiles;
+    std::unordered_map<Uint64, std::list<MUI_TiledImageTile>::iterator> tileMap;
+
+    size_t capacity;
+    int    prefetchBudget;
+    Uint32 frame;
+};
+
+int MUI_TiledImageLevelWidth(MUI_TiledImageHeader *header, int level)
+{
+    return SDL_max((int)(header->width >> level), 1);
+}
+
+int MUI_TiledImageLevelHeight(MUI_TiledImageHeader *header, int level)
+{
+    return SDL_max((int)(header->height >> level), 1);
+}
+
+int MUI_TiledImageTilesX(MUI_TiledImageHeader *header, int level)
+{
+    return (MUI_TiledImageLevelWidth(header, level) + header->tileSize - 1) / header->tileSize;
+}
+
+int MUI_TiledImageTilesY(MUI_TiledImageHeader *header, int level)
+{
+    return (MUI_TiledImageLevelHeight(header, level) + header->tileSize - 1) / header->tileSize;
+}
+
+// Converts a surface into an .mti file, halving with a 2x2 box filter until a level fits in one tile.
+bool MUI_TiledImageWrite(const char *path, SDL_Surface *surface, int tileSize)
+{
+    if (surface == nullptr || surface->w <= 0 || surface->h <= 0 || tileSize <= 0)
+    {
+        std::cout << "MUI INVALID TILED IMAGE SIZE " << path << std::endl;
+        return false;
+    }
+
+    SDL_Surface *level = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+
+    if (level == nullptr)
+    {
+        std::cout << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+    if (!file.is_open())
+    {
+        std::cout << "MUI FAILED OPENING TILED IMAGE " << path << std::endl;
+        SDL_FreeSurface(level);
+        return false;
+    }
+
+    MUI_TiledImageHeader header = {MUI_TILED_IMAGE_MAGIC, MUI_TILED_IMAGE_VERSION, (Uint32)level->w, (Uint32)level->h, (Uint32)tileSize, 1};
+
+    while (MUI_TiledImageLevelWidth(&header, header.levels - 1) > tileSize || MUI_TiledImageLevelHeight(&header, header.levels - 1) > tileSize)
+        header.levels++;
+
+    file.write((const char*)&header, sizeof(header));
+
+    std::vector<Uint32> tile(tileSize * tileSize);
+
+    for (Uint32 l = 0; l < header.levels; l++)
+    {
+        SDL_LockSurface(level);
+
+        for (int ty = 0; ty < MUI_TiledImageTilesY(&header, l); ty++)
+        {
+            for (int tx = 0; tx < MUI_TiledImageTilesX(&header, l); tx++)
+            {
+                std::fill(tile.begin(), tile.end(), 0);
+
+                int w = SDL_min(tileSize, level->w - tx * tileSize);
+                int h = SDL_min(tileSize, level->h - ty * tileSize);
+
+                for (int y = 0; y < h; y++)
+                    memcpy(&tile[y * tileSize], (Uint8*)level->pixels + (ty * tileSize + y) * level->pitch + tx * tileSize * 4, w * 4);
+
+                file.write((const char*)tile.data(), tile.size() * 4);
+            }
+        }
+
+        SDL_UnlockSurface(level);
+
+        if (l + 1 == header.levels)
+            break;
+
+        SDL_Surface *next = SDL_CreateRGBSurfaceWithFormat(0, MUI_TiledImageLevelWidth(&header, l + 1), MUI_TiledImageLevelHeight(&header, l + 1), 32, SDL_PIXELFORMAT_ARGB8888);
+
+        SDL_LockSurface(level);
+        SDL_LockSurface(next);
+
+        for (int y = 0; y < next->h; y++)
+        {
+            Uint8 *row0 = (Uint8*)level->pixels + SDL_min(y * 2,     level->h - 1) * level->pitch;
+            Uint8 *row1 = (Uint8*)level->pixels + SDL_min(y * 2 + 1, level->h - 1) * level->pitch;
+            Uint8 *out  = (Uint8*)next->pixels  + y * next->pitch;
+
+            for (int x = 0; x < next->w; x++)
+            {
+                int x0 = SDL_min(x * 2,     level->w - 1) * 4;
+                int x1 = SDL_min(x * 2 + 1, level->w - 1) * 4;
+
+                for (int c = 0; c < 4; c++)
+                    out[x * 4 + c] = (Uint8)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+            }
+        }
+
+        SDL_UnlockSurface(next);
+        SDL_UnlockSurface(level);
+        SDL_FreeSurface(level);
+
+        level = next;
+    }
+
+    SDL_FreeSurface(level);
+
+    return file.good();
+}
+
+const Uint8 *MUI_TiledImageTileData(MUI_TiledImage *image, int level, int tx, int ty)
+{
+    size_t tileBytes = (size_t)image->header.tileSize * image->header.tileSize * 4;
+
+    return image->data + image->levelOffsets[level] + ((size_t)ty * MUI_TiledImageTilesX(&image->header, level) + tx) * tileBytes;
+}
+
+Uint64 MUI_TiledImageTileKey(int level, int tx, int ty)
+{
+    return ((Uint64)level << 48) | ((Uint64)ty << 24) | (Uint64)tx;
+}
+
+// Returns the cached tile, uploading it straight from the mapping on a miss. Past capacity the least
+// recently used tile not drawn this frame gives up its texture.
+MUI_TiledImageTile *MUI_TiledImageGetTile(MUI_TiledImage *image, SDL_Renderer *renderer, int level, int tx, int ty)
+{
+    Uint64 key = MUI_TiledImageTileKey(level, tx, ty);
+    auto found = image->tileMap.find(key);
+
+    if (found != image->tileMap.end())
+    {
+        image->tiles.splice(image->tiles.begin(), image->tiles, found->second);
+        return &image->tiles.front();
+    }
+
+    SDL_Texture *texture = nullptr;
+
+    if (image->tiles.size() >= image->capacity && image->tiles.back().lastFrame != image->frame)
+    {
+        texture = image->tiles.back().texture;
+
+        image->tileMap.erase(image->tiles.back().key);
+        image->tiles.pop_back();
+    }
+
+    if (texture == nullptr)
+    {
+        texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, image->header.tileSize, image->header.tileSize);
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    }
+
+    SDL_UpdateTexture(texture, nullptr, MUI_TiledImageTileData(image, level, tx, ty), image->header.tileSize * 4);
+
+    image->tiles.push_front(MUI_TiledImageTile{key, texture, 0});
+    image->tileMap[key] = image->tiles.begin();
+
+    return &image->tiles.front();
+}
+
+void MUI_TiledImagePrefetch(MUI_TiledImage *image, SDL_Renderer *renderer, int level, int tx, int ty, int *budget)
+{
+    if (level < 0 || level >= (int)image->header.levels || tx < 0 || ty < 0
+        || tx >= MUI_TiledImageTilesX(&image->header, level) || ty >= MUI_TiledImageTilesY(&image->header, level))
+        return;
+
+    if (image->tileMap.count(MUI_TiledImageTileKey(level, tx, ty)) > 0)
+        return;
+
+    if (*budget > 0)
+    {
+        (*budget)--;
+        MUI_TiledImageGetTile(image, renderer, level, tx, ty)->lastFrame = image->frame;
+    }
+#if !defined(_WIN32)
+    else
+    {
+        size_t tileBytes = (size_t)image->header.tileSize * image->header.tileSize * 4;
+        uintptr_t page   = (uintptr_t)sysconf(_SC_PAGESIZE);
+        uintptr_t start  = (uintptr_t)MUI_TiledImageTileData(image, level, tx, ty) & ~(page - 1);
+
+        madvise((void*)start, tileBytes + page, MADV_WILLNEED);
+    }
+#endif
+}
+
+void MUI_TiledImageDraw(MUI_TiledImage *image, SDL_Renderer *renderer)
+{
+    SDL_Rect rect = image->element->destRect;
+
+    if (rect.w <= 0 || rect.h <= 0)
+        return;
+
+    MUI_TiledImageHeader *header = &image->header;
+
+    if (image->zoom <= 0.0f)
+    {
+        image->zoom  = SDL_min((float)rect.w / header->width, (float)rect.h / header->height);
+        image->viewX = 0.0f;
+        image->viewY = 0.0f;
+    }
+
+    image->frame++;
+
+    int level = (int)SDL_floor(SDL_log(1.0 / image->zoom) / SDL_log(2.0));
+    level = SDL_clamp(level, 0, (int)header->levels - 1);
+
+    float levelScale = (float)(1 << level);
+    float tileSource = header->tileSize * levelScale;
+
+    int tx0 = SDL_max((int)SDL_floor(image->viewX / tileSource), 0);
+    int ty0 = SDL_max((int)SDL_floor(image->viewY / tileSource), 0);
+    int tx1 = SDL_min((int)SDL_floor((image->viewX + rect.w / image->zoom) / tileSource), MUI_TiledImageTilesX(header, level) - 1);
+    int ty1 = SDL_min((int)SDL_floor((image->viewY + rect.h / image->zoom) / tileSource), MUI_TiledImageTilesY(header, level) - 1);
+
+    SDL_Rect clipRect;
+    bool clipped = SDL_RenderIsClipEnabled(renderer);
+
+    SDL_RenderGetClipRect(renderer, &clipRect);
+    SDL_RenderSetClipRect(renderer, &rect);
+
+    for (int ty = ty0; ty <= ty1; ty++)
+    {
+        for (int tx = tx0; tx <= tx1; tx++)
+        {
+            MUI_TiledImageTile *tile = MUI_TiledImageGetTile(image, renderer, level, tx, ty);
+            tile->lastFrame = image->frame;
+
+            SDL_Rect srcRect = {0, 0, 0, 0};
+            srcRect.w = SDL_min((int)header->tileSize, MUI_TiledImageLevelWidth(header, level)  - tx * (int)header->tileSize);
+            srcRect.h = SDL_min((int)header->tileSize, MUI_TiledImageLevelHeight(header, level) - ty * (int)header->tileSize);
+
+            // Edges come from the same rounding on both sides of a seam so neighbouring tiles never gap.
+            int x0 = rect.x + (int)SDL_floor((tx * tileSource - image->viewX) * image->zoom);
+            int y0 = rect.y + (int)SDL_floor((ty * tileSource - image->viewY) * image->zoom);
+            int x1 = rect.x + (int)SDL_floor((tx * tileSource + srcRect.w * levelScale - image->viewX) * image->zoom);
+            int y1 = rect.y + (int)SDL_floor((ty * tileSource + srcRect.h * levelScale - image->viewY) * image->zoom);
+
+            SDL_Rect destRect = {x0, y0, x1 - x0, y1 - y0};
+
+            SDL_RenderCopy(renderer, tile->texture, &srcRect, &destRect);
+        }
+    }
+
+    SDL_RenderSetClipRect(renderer, clipped ? &clipRect : nullptr);
+
+    while (image->tiles.size() > image->capacity && image->tiles.back().lastFrame != image->frame)
+    {
+        SDL_DestroyTexture(image->tiles.back().texture);
+
+        image->tileMap.erase(image->tiles.back().key);
+        image->tiles.pop_back();
+    }
+
+    // Prefetch the next row / column in the direction of the pan and the level the zoom is heading to.
+    int budget = image->prefetchBudget;
+
+    float panX = image->viewX - image->lastViewX;
+    float panY = image->viewY - image->lastViewY;
+
+    if (panX != 0.0f)
+        for (int ty = ty0; ty <= ty1; ty++)
+            MUI_TiledImagePrefetch(image, renderer, level, (panX > 0.0f) ? tx1 + 1 : tx0 - 1, ty, &budget);
+
+    if (panY != 0.0f)
+        for (int tx = tx0; tx <= tx1; tx++)
+            MUI_TiledImagePrefetch(image, renderer, level, tx, (panY > 0.0f) ? ty1 + 1 : ty0 - 1, &budget);
+
+    if (image->zoom != image->lastZoom)
+    {
+        int nextLevel = (image->zoom > image->lastZoom) ? level - 1 : level + 1;
+
+        if (nextLevel >= 0 && nextLevel < (int)header->levels)
+        {
+            float nextSource = header->tileSize * (float)(1 << nextLevel);
+
+            int nx0 = SDL_max((int)SDL_floor(image->viewX / nextSource), 0);
+            int ny0 = SDL_max((int)SDL_floor(image->viewY / nextSource), 0);
+            int nx1 = SDL_min((int)SDL_floor((image->viewX + rect.w / image->zoom) / nextSource), MUI_TiledImageTilesX(header, nextLevel) - 1);
+            int ny1 = SDL_min((int)SDL_floor((image->viewY + rect.h / image->zoom) / nextSource), MUI_TiledImageTilesY(header, nextLevel) - 1);
+
+            for (int ty = ny0; ty <= ny1; ty++)
+                for (int tx = nx0; tx <= nx1; tx++)
+                    MUI_TiledImagePrefetch(image, renderer, nextLevel, tx, ty, &budget);
+        }
+    }
+
+    image->lastViewX = image->viewX;
+    image->lastViewY = image->viewY;
+    image->lastZoom  = image->zoom;
+}
+
+void MUI_TiledImageUnmap(MUI_TiledImage *image)
+{
+#if defined(_WIN32)
+    if (image->data != nullptr)
+        UnmapViewOfFile(image->data);
+    if (image->mapping != nullptr)
+        CloseHandle(image->mapping);
+    if (image->file != INVALID_HANDLE_VALUE)
+        CloseHandle(image->file);
+#else
+    if (image->data != nullptr)
+        munmap((void*)image->data, image->dataSize);
+    if (image->file >= 0)
+        close(image->file);
+#endif
+
+    image->data = nullptr;
+}
+
+// Memory maps an .mti file, nothing is read until tiles are drawn. cacheTiles bounds the resident textures,
+// it should at least cover the tiles visible at once plus prefetchBudget.
+MUI_TiledImage *MUI_CreateTiledImage(SDL_Renderer *renderer, const char *path, MUI_Vector2 position, MUI_Vector2 size, int scaling, int scaleTo, size_t cacheTiles)
+{
+    MUI_TiledImage *image = new MUI_TiledImage;
+
+    image->data     = nullptr;
+    image->dataSize = 0;
+
+#if defined(_WIN32)
+    image->mapping = nullptr;
+    image->file    = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+
+    if (image->file != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER fileSize;
+        GetFileSizeEx(image->file, &fileSize);
+
+        image->dataSize = (size_t)fileSize.QuadPart;
+        image->mapping  = CreateFileMappingA(image->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+        if (image->mapping != nullptr)
+            image->data = (const Uint8*)MapViewOfFile(image->mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+#else
+    image->file = open(path, O_RDONLY);
+
+    struct stat fileStat;
+
+    if (image->file >= 0 && fstat(image->file, &fileStat) == 0)
+    {
+        image->dataSize = (size_t)fileStat.st_size;
+
+        void *data = mmap(nullptr, image->dataSize, PROT_READ, MAP_PRIVATE, image->file, 0);
+
+        if (data != MAP_FAILED)
+            image->data = (const Uint8*)data;
+    }
+#endif
+
+    bool valid = image->data != nullptr && image->dataSize >= sizeof(MUI_TiledImageHeader);
+
+    if (valid)
+    {
+        memcpy(&image->header, image->data, sizeof(MUI_TiledImageHeader));
+
+        valid = image->header.magic == MUI_TILED_IMAGE_MAGIC && image->header.version == MUI_TILED_IMAGE_VERSION
+                && image->header.width > 0 && image->header.height > 0
+                && image->header.tileSize > 0 && image->header.levels > 0 && image->header.levels < 32;
+    }
+
+    if (valid)
+    {
+        size_t offset    = sizeof(MUI_TiledImageHeader);
+        size_t tileBytes = (size_t)image->header.tileSize * image->header.tileSize * 4;
+
+        for (Uint32 l = 0; l < image->header.levels; l++)
+        {
+            image->levelOffsets.push_back(offset);
+            offset += (size_t)MUI_TiledImageTilesX(&image->header, l) * MUI_TiledImageTilesY(&image->header, l) * tileBytes;
+        }
+
+        valid = offset <= image->dataSize;
+    }
+
+    if (!valid)
+    {
+        std::cout << "MUI FAILED LOADING TILED IMAGE " << path << std::endl;
+
+        MUI_TiledImageUnmap(image);
+        delete image;
+
+        return nullptr;
+    }
+
+    image->viewX          = 0.0f;
+    image->viewY          = 0.0f;
+    image->zoom           = 0.0f;
+    image->lastViewX      = 0.0f;
+    image->lastViewY      = 0.0f;
+    image->lastZoom       = 0.0f;
+    image->capacity       = SDL_max(cacheTiles, (size_t)1);
+    image->prefetchBudget = 4;
+    image->frame          = 0;
+
+    image->element = MUI_CreateFrame(renderer, SDL_Color{0, 0, 0, 255}, position, size, scaling, scaleTo, false, false);
+    image->element->Draw = [image](SDL_Renderer *renderer, MUI_Element *)
+    {
+        MUI_TiledImageDraw(image, renderer);
+    };
+
+    return image;
+}
+
+void MUI_TiledImageSetView(MUI_TiledImage *image, float x, float y, float zoom)
+{
+    image->viewX = x;
+    image->viewY = y;
+    image->zoom  = zoom;
+}
+
+// Pans by a distance in screen pixels.
+void MUI_TiledImagePan(MUI_TiledImage *image, float x, float y)
+{
+    if (image->zoom <= 0.0f)
+        return;
+
+    image->viewX -= x / image->zoom;
+    image->viewY -= y / image->zoom;
+}
+
+// Zooms by factor keeping the source pixel under the screen point in place.
+void MUI_TiledImageZoomAt(MUI_TiledImage *image, float factor, int screenX, int screenY)
+{
+    if (image->zoom <= 0.0f)
+        return;
+
+    float x = (float)(screenX - image->element->destRect.x);
+    float y = (float)(screenY - image->element->destRect.y);
+
+    image->viewX += x / image->zoom - x / (image->zoom * factor);
+    image->viewY += y / image->zoom - y / (image->zoom * factor);
+    image->zoom  *= factor;
+}
+
+void MUI_DestroyTiledImage(MUI_TiledImage *image)
+{
+    for (MUI_TiledImageTile &tile : image->tiles)
+        SDL_DestroyTexture(tile.texture);
+
+    MUI_TiledImageUnmap(image);
+    MUI_DestroyElement(image->element);
+
+    delete image;
+}
+
+
+
+// STREAMING PLOT //
+
+// Samples go into a lock-free ring any thread can append to. The UI thread folds new samples into one
+// min/max bucket per pixel column as they arrive and draws the buckets, so a frame costs the plot's width.
+
+#define MUI_PLOT_BUSY (~(Uint64)0)
+
+class MUI_Plot
+{
+public:
+    MUI_Element *element;
+    SDL_Color    lineColor;
+
+    // A producer claims an index from writeIndex, marks the slot MUI_PLOT_BUSY, stores the value and publishes it
+    // by writing index + 1 to the slot's sequence. A slot whose sequence moved past the index it was read for was overwritten.
+    std::vector<std::atomic<float>>  values;
+    std::vector<std::atomic<Uint64>> sequence;
+    std::atomic<Uint64> writeIndex;
+    Uint64 mask;
+
+    Uint64 readIndex;
+
+    // Samples across the plot width, and the fixed y range used when autoScale is off.
+    size_t span;
+    bool   autoScale;
+    float  rangeMin;
+    float  rangeMax;
+
+    // Ring of columns, column n holds samples [n * samplesPerColumn, (n + 1) * samplesPerColumn).
+    int    columns;
+    Uint64 samplesPerColumn;
+    Uint64 headColumn;
+    std::vector<float> columnMin;
+    std::vector<float> columnMax;
+    std::vector<float> columnLast;
+
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int>        indices;
+
+    MUI_Plot(size_t capacity) : values(capacity), sequence(capacity), writeIndex(0) {}
+};
+
+void MUI_PlotAppend(MUI_Plot *plot, float value)
+{
+    Uint64 index = plot->writeIndex.fetch_add(1, std::memory_order_relaxed);
+    Uint64 slot  = index & plot->mask;
+
+    plot->sequence[slot].store(MUI_PLOT_BUSY, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    plot->values[slot].store(value, std::memory_order_relaxed);
+    plot->sequence[slot].store(index + 1, std::memory_order_release);
+}
+
+// Reads sample index back from the ring, false if it was not published yet or has been overwritten.
+bool MUI_PlotRead(MUI_Plot *plot, Uint64 index, float *value)
+{
+    Uint64 slot     = index & plot->mask;
+    Uint64 sequence = plot->sequence[slot].load(std::memory_order_acquire);
+
+    if (sequence == MUI_PLOT_BUSY || sequence != index + 1)
+        return false;
+
+    *value = plot->values[slot].load(std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    return plot->sequence[slot].load(std::memory_order_relaxed) == index + 1;
+}
+
+void MUI_PlotFold(MUI_Plot *plot, Uint64 index, float value)
+{
+    Uint64 column = index / plot->samplesPerColumn;
+
+    if (column > plot->headColumn)
+    {
+        for (Uint64 c = SDL_max(plot->headColumn + 1, column - SDL_min(column, (Uint64)plot->columns - 1)); c <= column; c++)
+        {
+            size_t slot = c % plot->columns;
+
+            plot->columnMin[slot] = INFINITY;
+            plot->columnMax[slot] = -INFINITY;
+        }
+
+        plot->headColumn = column;
+    }
+    else if (column + plot->columns <= plot->headColumn)
+        return;
+
+    size_t slot = column % plot->columns;
+
+    plot->columnMin[slot]  = SDL_min(plot->columnMin[slot], value);
+    plot->columnMax[slot]  = SDL_max(plot->columnMax[slot], value);
+    plot->columnLast[slot] = value;
+}
+
+// Rebuilds every column from the ring after the width or span changed.
+void MUI_PlotRebuild(MUI_Plot *plot, int columns)
+{
+    plot->columns          = columns;
+    plot->samplesPerColumn = SDL_max((Uint64)((plot->span + columns - 1) / columns), (Uint64)1);
+
+    plot->columnMin.assign(columns, INFINITY);
+    plot->columnMax.assign(columns, -INFINITY);
+    plot->columnLast.assign(columns, 0.0f);
+
+    Uint64 available = SDL_min(plot->readIndex, (Uint64)plot->span);
+    Uint64 start     = plot->readIndex - available;
+
+    plot->headColumn = start / plot->samplesPerColumn;
+
+    for (Uint64 index = start; index < plot->readIndex; index++)
+    {
+        float value;
+
+        if (MUI_PlotRead(plot, index, &value))
+            MUI_PlotFold(plot, index, value);
+    }
+}
+
+void MUI_PlotIngest(MUI_Plot *plot)
+{
+    Uint64 end = plot->writeIndex.load(std::memory_order_acquire);
+
+    if (end - plot->readIndex > plot->mask + 1)
+        plot->readIndex = end - (plot->mask + 1);
+
+    while (plot->readIndex < end)
+    {
+        float value;
+        Uint64 slot = plot->readIndex & plot->mask;
+
+        // Claimed but not stored yet, or being stored right now, pick it up next frame.
+        Uint64 sequence = plot->sequence[slot].load(std::memory_order_acquire);
+
+        if (sequence == MUI_PLOT_BUSY || sequence < plot->readIndex + 1)
+            break;
+
+        if (MUI_PlotRead(plot, plot->readIndex, &value))
+            MUI_PlotFold(plot, plot->readIndex, value);
+
+        plot->readIndex++;
+    }
+}
+
+void MUI_PlotDraw(MUI_Plot *plot, SDL_Renderer *renderer)
+{
+    SDL_Rect rect = plot->element->destRect;
+
+    if (rect.w <= 0 || rect.h <= 0)
+        return;
+
+    if (rect.w != plot->columns)
+        MUI_PlotRebuild(plot, rect.w);
+
+    MUI_PlotIngest(plot);
+
+    Uint64 first = plot->headColumn - SDL_min(plot->headColumn, (Uint64)plot->columns - 1);
+
+    float low  = plot->rangeMin;
+    float high = plot->rangeMax;
+
+    if (plot->autoScale)
+    {
+        low  = INFINITY;
+        high = -INFINITY;
+
+        for (Uint64 c = first; c <= plot->headColumn; c++)
+        {
+            low  = SDL_min(low,  plot->columnMin[c % plot->columns]);
+            high = SDL_max(high, plot->columnMax[c % plot->columns]);
+        }
+
+        if (low > high)
+            return;
+    }
+
+    float scale = (high > low) ? (float)rect.h / (high - low) : 0.0f;
+
+    plot->vertices.clear();
+
+    SDL_Vertex vertex;
+    vertex.color     = plot->lineColor;
+    vertex.tex_coord = SDL_FPoint{0.0f, 0.0f};
+
+    bool  connected = false;
+    float previous  = 0.0f;
+
+    // One quad per column spanning its min and max, stretched to the previous column's last sample so
+    // the envelope stays continuous.
+    for (Uint64 c = first; c <= plot->headColumn; c++)
+    {
+        size_t slot = c % plot->columns;
+
+        if (plot->columnMin[slot] > plot->columnMax[slot])
+        {
+            connected = false;
+            continue;
+        }
+
+        float columnLow  = plot->columnMin[slot];
+        float columnHigh = plot->columnMax[slot];
+
+        if (connected)
+        {
+            columnLow  = SDL_min(columnLow,  previous);
+            columnHigh = SDL_max(columnHigh, previous);
+        }
+
+        float x      = (float)(rect.x + rect.w - 1 - (int)(plot->headColumn - c));
+        float top    = (float)(rect.y + rect.h) - (SDL_clamp(columnHigh, low, high) - low) * scale;
+        float bottom = (float)(rect.y + rect.h) - (SDL_clamp(columnLow,  low, high) - low) * scale;
+
+        bottom = SDL_max(bottom, top + 1.0f);
+
+        vertex.position = SDL_FPoint{x,        top};    plot->vertices.push_back(vertex);
+        vertex.position = SDL_FPoint{x + 1.0f, top};    plot->vertices.push_back(vertex);
+        vertex.position = SDL_FPoint{x + 1.0f, bottom}; plot->vertices.push_back(vertex);
+        vertex.position = SDL_FPoint{x,        bottom}; plot->vertices.push_back(vertex);
+
+        connected = true;
+        previous  = plot->columnLast[slot];
+    }
+
+    int quads = (int)plot->vertices.size() / 4;
+
+    while ((int)plot->indices.size() < quads * 6)
+    {
+        int base = (int)plot->indices.size() / 6 * 4;
+        int quad[6] = {base, base + 1, base + 2, base, base + 2, base + 3};
+
+        plot->indices.insert(plot->indices.end(), quad, quad + 6);
+    }
+
+    if (quads > 0)
+        SDL_RenderGeometry(renderer, nullptr, plot->vertices.data(), quads * 4, plot->indices.data(), quads * 6);
+}
+
+// capacity is rounded up to a power of two and bounds how far producers can run ahead of drawing.
+MUI_Plot *MUI_CreatePlot(SDL_Renderer *renderer, SDL_Color lineColor, SDL_Color backgroundColor, MUI_Vector2 position, MUI_Vector2 size, int scaling, int scaleTo, size_t capacity)
+{
+    size_t ringSize = 1;
+
+    while (ringSize < capacity)
+        ringSize <<= 1;
+
+    MUI_Plot *plot = new MUI_Plot(ringSize);
+
+    for (std::atomic<Uint64> &slotSequence : plot->sequence)
+        slotSequence.store(0, std::memory_order_relaxed);
+
+    plot->lineColor        = lineColor;
+    plot->mask             = ringSize - 1;
+    plot->readIndex        = 0;
+    plot->span             = ringSize;
+    plot->autoScale        = true;
+    plot->rangeMin         = 0.0f;
+    plot->rangeMax         = 1.0f;
+    plot->columns          = 0;
+    plot->samplesPerColumn = 1;
+    plot->headColumn       = 0;
+
+    plot->element = MUI_CreateFrame(renderer, backgroundColor, position, size, scaling, scaleTo, false, false);
+    plot->element->Draw = [plot](SDL_Renderer *renderer, MUI_Element *)
+    {
+        MUI_PlotDraw(plot, renderer);
+    };
+
+    return plot;
+}
+
+// Number of most recent samples shown across the width, at most the ring capacity.
+void MUI_PlotSetSpan(MUI_Plot *plot, size_t span)
+{
+    plot->span    = SDL_clamp(span, (size_t)1, (size_t)(plot->mask + 1));
+    plot->columns = 0;
+}
+
+void MUI_PlotSetRange(MUI_Plot *plot, float rangeMin, float rangeMax)
+{
+    plot->autoScale = false;
+    plot->rangeMin  = rangeMin;
+    plot->rangeMax  = rangeMax;
+}
+
+void MUI_DestroyPlot(MUI_Plot *plot)
+{
+    MUI_DestroyElement(plot->element);
+
+    delete plot;
+}
+
+
+
+// OFFSCREEN RENDERING //
+
+// All frame state lives in MUI_Updater, so updaters on different threads can lay out and render their own
+// trees at once. SDL_ttf is not thread safe, threads share fonts and rendered text through one
+// MUI_TextCache instead of calling MUI_CreateText / MUI_UpdateText.
+
+MUI_Updater *MUI_CreateOffscreenUpdater(int width, int height)
+{
+    MUI_Updater *updater = new MUI_Updater();
+
+    updater->windowSizeX = width;
+    updater->windowSizeY = height;
+    updater->mouseX      = -1;
+    updater->mouseY      = -1;
+    updater->event       = MUI_NOEVENT;
+
+    updater->offscreenSurface  = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+    updater->offscreenRenderer = (updater->offscreenSurface != nullptr) ? SDL_CreateSoftwareRenderer(updater->offscreenSurface) : nullptr;
+
+    if (updater->offscreenRenderer == nullptr)
+        std::cout << SDL_GetError() << std::endl;
+
+    return updater;
+}
+
+// Renders one frame of the updater's tree without input and returns the surface holding it.
+SDL_Surface *MUI_RenderOffscreen(MUI_Updater *updater)
+{
+    SDL_Renderer *renderer = updater->offscreenRenderer;
+
+    SDL_Event event = {};
+    event.type = SDL_FIRSTEVENT;
+
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+    MUI_UpdateLayout(updater, renderer);
+    MUI_Update(updater, renderer, event);
+    MUI_SoftwareBackendPresent(updater, renderer);
+    SDL_RenderPresent(renderer);
+
+    return updater->offscreenSurface;
+}
+
+void MUI_DestroyOffscreenUpdater(MUI_Updater *updater)
+{
+    if (updater->offscreenRenderer != nullptr)
+        SDL_DestroyRenderer(updater->offscreenRenderer);
+
+    if (updater->offscreenSurface != nullptr)
+        SDL_FreeSurface(updater->offscreenSurface);
+
+    delete updater;
+}
+
+typedef std::tuple<TTF_Font*, Uint32, std::string> MUI_TextCacheKey;
+
+struct MUI_TextCacheEntry
+{
+    MUI_TextCacheKey key;
+    SDL_Surface     *surface;
+};
+
+class MUI_TextCache
+{
+public:
+    std::mutex mutex;
+    size_t     capacity;
+
+    std::map<std::pair<std::string, int>, TTF_Font*> fonts;
+
+    // Most recently used first, past capacity the tail is freed. Elements hold their own copies.
+    std::list<MUI_TextCacheEntry> entries;
+    std::map<MUI_TextCacheKey, std::list<MUI_TextCacheEntry>::iterator> surfaces;
+};
+
+MUI_TextCache *MUI_CreateTextCache(size_t capacity = 256)
+{
+    MUI_TextCache *cache = new MUI_TextCache;
+
+    cache->capacity = SDL_max(capacity, (size_t)1);
+
+    return cache;
+}
+
+TTF_Font *MUI_TextCacheFont(MUI_TextCache *cache, const char *path, int size)
+{
+    std::lock_guard<std::mutex> lock(cache->mutex);
+
+    TTF_Font *&font = cache->fonts[std::make_pair(std::string(path), size)];
+
+    if (font == nullptr)
+    {
+        font = TTF_OpenFont(path, size);
+
+        if (font == nullptr)
+            std::cout << TTF_GetError() << std::endl;
+    }
+
+    return font;
+}
+
+SDL_Surface *MUI_CopySurface(SDL_Surface *surface)
+{
+    SDL_Surface *copy = SDL_CreateRGBSurfaceWithFormat(0, surface->w, surface->h, 32, SDL_PIXELFORMAT_ARGB8888);
+
+    if (copy != nullptr)
+        for (int y = 0; y < surface->h; y++)
+            memcpy((Uint8*)copy->pixels + y * copy->pitch, (Uint8*)surface->pixels + y * surface->pitch, surface->w * 4);
+
+    return copy;
+}
+
+// Rasterizes text once per font, color and string, then gives the element its own texture and, with keepSurface,
+// its own surface copy. Only the lookup and rasterizing run under the cache lock, the texture
+// and copy are made from a reference taken under it, so updaters on other threads are not held up by them.
+void MUI_TextCacheApply(MUI_TextCache *cache, SDL_Renderer *renderer, MUI_Element *element, TTF_Font *font, const char *text, SDL_Color textColor)
+{
+    std::unique_lock<std::mutex> lock(cache->mutex);
+
+    Uint32 color = ((Uint32)textColor.a << 24) | ((Uint32)textColor.r << 16) | ((Uint32)textColor.g << 8) | textColor.b;
+    MUI_TextCacheKey key = std::make_tuple(font, color, std::string(text));
+
+    auto found = cache->surfaces.find(key);
+    SDL_Surface *surface;
+
+    if (found != cache->surfaces.end())
+    {
+        cache->entries.splice(cache->entries.begin(), cache->entries, found->second);
+        surface = found->second->surface;
+    }
+    else
+    {
+        surface = MUI_ConvertSurface(TTF_RenderText_Blended(font, text, textColor));
+
+        if (surface == nullptr)
+        {
+            std::cout << TTF_GetError() << std::endl;
+            return;
+        }
+
+        cache->entries.push_front(MUI_TextCacheEntry{key, surface});
+        cache->surfaces[key] = cache->entries.begin();
+
+        while (cache->entries.size() > cache->capacity)
+        {
+            SDL_FreeSurface(cache->entries.back().surface);
+
+            cache->surfaces.erase(cache->entries.back().key);
+            cache->entries.pop_back();
+        }
+    }
+
+    // Reference counts are only touched under the lock, the shared surface itself is only read.
+    surface->refcount++;
+    lock.unlock();
+
+    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
+
+    if (texture == NULL)
+        std::cout << SDL_GetError() << std::endl;
+
+    SDL_Surface *copy = element->keepSurface ? MUI_CopySurface(surface) : nullptr;
+
+    lock.lock();
+    SDL_FreeSurface(surface);
+    lock.unlock();
+
+    if (element->texture != nullptr)
+        SDL_DestroyTexture(element->texture);
+    if (element->surface != nullptr)
+        SDL_FreeSurface(element->surface);
+
+    element->texture = texture;
+    element->surface = copy;
+}
+
+MUI_Element *MUI_CreateCachedText(SDL_Renderer *renderer, MUI_TextCache *cache, const char *text, TTF_Font *font, SDL_Color textColor, SDL_Color backgroundColor, MUI_Vector2 position, MUI_Vector2 size, int scaling, int scaleTo, bool clickable, bool draggable, bool keepSurface = false)
+{
+    MUI_Element *element = MUI_CreateFrame(renderer, backgroundColor, position, size, scaling, scaleTo, clickable, draggable);
+
+    element->srcRect     = &element->destRect;
+    element->keepSurface = keepSurface;
+
+    MUI_TextCacheApply(cache, renderer, element, font, text, textColor);
+
+    return element;
+}
+
+void MUI_UpdateCachedText(SDL_Renderer *renderer, MUI_TextCache *cache, MUI_Element *element, const char *text, TTF_Font *font, SDL_Color textColor)
+{
+    MUI_TextCacheApply(cache, renderer, element, font, text, textColor);
+    MUI_ElementInvalidateLayout(element);
+}
+
+// Frees every cached surface, fonts stay open.
+void MUI_TextCachePurge(MUI_TextCache *cache)
+{
+    std::lock_guard<std::mutex> lock(cache->mutex);
+
+    for (MUI_TextCacheEntry &entry : cache->entries)
+        SDL_FreeSurface(entry.surface);
+
+    cache->entries.clear();
+    cache->surfaces.clear();
+}
+
+void MUI_DestroyTextCache(MUI_TextCache *cache)
+{
+    for (MUI_TextCacheEntry &entry : cache->entries)
+        SDL_FreeSurface(entry.surface);
+
+    for (auto &entry : cache->fonts)
+        if (entry.second != nullptr)
+            TTF_CloseFont(entry.second);
+
+    delete cache;
+}
@@ -0,0 +1,83 @@
+#include <iostream>
+#include <vector>
+#include <SDL2/SDL.h>
+
+#include "../headers/MUI.hh"
+
+// Compares MUI_LayoutBatch against per element MUI_ElementLayout, the path MUI_RecursiveCopy uses, on a wide list of siblings.
+// Usage: layout_bench [siblings] [iterations]
+
+int main(int argc, char *argv[])
+{
+    int siblings   = argc > 1 ? atoi(argv[1]) : 4096;
+    int iterations = argc > 2 ? atoi(argv[2]) : 2000;
+
+    if (siblings <= 0 || iterations <= 0)
+        return -1;
+
+    MUI_Updater *updater = new MUI_Updater;
+    updater->windowSizeX = 1920;
+    updater->windowSizeY = 1080;
+
+    MUI_Element *parent = MUI_CreateFrame(nullptr, {0, 0, 0, 255}, MUI_Vector2(0.05f, 0.05f), MUI_Vector2(0.9f, 0.9f), MUI_SCALING_SCALE, MUI_SCALE_XY, false, false);
+    MUI_ElementUpdatedestRect(parent, updater);
+
+    std::vector<MUI_Element*> elements;
+
+    for (int i = 0; i < siblings; i++)
+    {
+        float t = (float)i / (float)siblings;
+
+        MUI_Element *element = MUI_CreateFrame(nullptr, {255, 255, 255, 255}, MUI_Vector2(t, 1.0f - t), MUI_Vector2(0.1f + t * 0.5f, 0.05f), MUI_SCALING_SCALE, MUI_SCALE_XY, false, false);
+        MUI_ElementSetParent(element, parent);
+
+        elements.push_back(element);
+    }
+
+    std::vector<SDL_Rect> rects(siblings);
+
+    // Both paths have to agree before the timings mean anything.
+    MUI_LayoutBatch(elements.data(), elements.size(), updater, rects.data());
+
+    int mismatches = 0;
+
+    for (int i = 0; i < siblings; i++)
+    {
+        MUI_ElementLayout(elements[i], updater);
+
+        if (memcmp(&rects[i], &elements[i]->destRect, sizeof(SDL_Rect)) != 0)
+            mismatches++;
+    }
+
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 start     = SDL_GetPerformanceCounter();
+
+    for (int k = 0; k < iterations; k++)
+        MUI_LayoutBatch(elements.data(), elements.size(), updater, rects.data());
+
+    Uint64 batchEnd = SDL_GetPerformanceCounter();
+
+    for (int k = 0; k < iterations; k++)
+        for (MUI_Element *element : elements)
+            MUI_ElementLayout(element, updater);
+
+    Uint64 scalarEnd = SDL_GetPerformanceCounter();
+
+    double total      = (double)siblings * (double)iterations;
+    double batchNs    = (double)(batchEnd - start)      * 1e9 / (double)frequency / total;
+    double scalarNs   = (double)(scalarEnd - batchEnd)  * 1e9 / (double)frequency / total;
+
+    std::cout << "siblings "   << siblings   << ", iterations " << iterations << std::endl;
+    std::cout << "mismatches " << mismatches << std::endl;
+    std::cout << "MUI_LayoutBatch            " << batchNs  << " ns/element" << std::endl;
+    std::cout << "MUI_ElementLayout          " << scalarNs << " ns/element" << std::endl;
+    std::cout << "speedup                    " << scalarNs / batchNs << "x" << std::endl;
+
+    for (MUI_Element *element : elements)
+        MUI_DestroyElement(element);
+
+    MUI_DestroyElement(parent);
+    delete updater;
+
+    return mismatches == 0 ? 0 : -1;
+}
@@ -35,6 +35,7 @@ int main(int argc, char *argv[])
         std::cout << TTF_GetError() << std::endl;
 
     MUI_Updater *updater = MUI_CreateUpdater(window);
+    updater->lowLatencyDrag = true;
 
     MUI_Element *numberFrame   = MUI_CreateFrame(renderer, SDL_Color{72,0,72,255}, MUI_Vector2(0,0.25), MUI_Vector2(0.75,0.75), MUI_SCALING_SCALE, MUI_SCALE_XY, false, false);
     MUI_Element *operatorFrame = MUI_CreateFrame(renderer, SDL_Color{50,0,50,255}, MUI_Vector2(0.75,0.25), MUI_Vector2(0.25,0.75), MUI_SCALING_SCALE, MUI_SCALE_XY, false, false);
@@ -43,6 +44,11 @@ int main(int argc, char *argv[])
 
     functionFrame->visible = false;
 
+    numberFrame->layout        = MUI_LAYOUT_GRID;
+    numberFrame->layoutColumns = 3;
+    operatorFrame->layout      = MUI_LAYOUT_GRID;
+    functionFrame->layout      = MUI_LAYOUT_GRID;
+
     std::vector<int>  funcs = {MUI_CALCULATOR_SIN, MUI_CALCULATOR_COS, MUI_CALCULATOR_HTAN, MUI_CALCULATOR_SIGMOID, MUI_CALCULATOR_RELU};
     std::vector<char> ops   = {'+', '-', '/', '*'};
 
@@ -60,9 +66,11 @@ int main(int argc, char *argv[])
             functionFrame->visible = false;
     };
 
-    MUI_ElementSetParent(funcOpenButton, numberFrame);
     MUI_ElementSetParent(sumText, resultFrame);
 
+    MUI_Observable<double> sumValue(sum);
+    MUI_BindText<double>(updater, sumText, &sumValue, font1, SDL_Color{255,255,255,255}, [](const double &value) { return std::to_string(value); });
+
 
     for (int i = 0; i < funcs.size(); i++)
     {
@@ -128,20 +136,12 @@ int main(int argc, char *argv[])
         MUI_ElementSetParent(opButton, operatorFrame);
     }
 
-    float x = 0;
-    float y = 0;
     for (int i = 0; i < 10; i++)
     {
-        if (x > 2.0f)
-        {
-            y++;
-            x = 0.0f;
-        }
-
         if (i == 9)
-            x = 1.0f;
+            MUI_ElementSetParent(funcOpenButton, numberFrame);
 
-        MUI_Element *numberButton = MUI_CreateText(renderer, std::to_string(i).c_str(), font2, SDL_Color{255,255,255,255}, SDL_Color{100,0,100,255}, MUI_Vector2(x * (1.0f / 3.0f), y * 0.25f), MUI_Vector2((1.0f / 3.0f), 0.25f), MUI_SCALING_SCALE, MUI_SCALE_XY, true, false);
+        MUI_Element *numberButton = MUI_CreateText(renderer, std::to_string(i).c_str(), font2, SDL_Color{255,255,255,255}, SDL_Color{100,0,100,255}, MUI_Vector2(0, 0), MUI_Vector2(0, 0), MUI_SCALING_SCALE, MUI_SCALE_XY, true, false);
 
         numberButton->Clicked = [&sum, i, &op]()
         {
@@ -169,8 +169,6 @@ int main(int argc, char *argv[])
         };
 
         MUI_ElementSetParent(numberButton, numberFrame);
-
-        x++;
     }
 
     //operatorFrame->visible = false;
@@ -183,11 +181,12 @@ int main(int argc, char *argv[])
 
     while (running)
     {
-        MUI_UpdateText(renderer, sumText, std::to_string(sum).c_str(), font1, SDL_Color{255,255,255,255});
+        sumValue.Set(sum);
         
         SDL_PollEvent(&event);
         SDL_RenderClear(renderer);
         MUI_Update(updater, renderer, event);
+        MUI_RenderDragLate(updater, renderer);
         SDL_RenderPresent(renderer);
 
         switch (updater->event)